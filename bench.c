@@ -0,0 +1,191 @@
+/*****************************************************************************
+ * bench.c
+ * Benchmark harness for the game_of_life engines, replacing the old
+ * wall-clock "timing" script.  Each (engine, board, thread count) cell is
+ * run GOL_BENCH_WARMUP times untimed and then GOL_BENCH_REPS times timed,
+ * and one CSV row is printed with the median and standard deviation of
+ * the repetitions plus cells updated per second as the primary metric.
+ *
+ * Knobs (all environment variables, matching the rest of the tree):
+ *   GOL_BENCH_ENGINES  comma-separated GOL_ENGINE values
+ *                      (default "seq,parallel,tile,bit,sparse,stream")
+ *   GOL_BENCH_THREADS  comma-separated thread counts (default the
+ *                      gol_num_threads() value)
+ *   GOL_BENCH_REPS     timed repetitions per cell (default 5)
+ *   GOL_BENCH_WARMUP   untimed warmup runs per cell (default 1)
+ ****************************************************************************/
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "life.h"
+#include "load.h"
+
+#define MAX_LIST 64
+
+static void
+print_usage(const char argv0[]) {
+    fprintf(stderr,
+            "\nUsage: %s <num_generations> <infilename> [<infilename> ...]\n\n"
+                    "\t<num_generations>: nonnegative number of generations per run\n"
+                    "\t<infilename>:      board(s) to benchmark every engine on\n"
+                    "\n\n", argv0);
+}
+
+static double
+now_seconds(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + 1.0e-6 * tv.tv_usec;
+}
+
+/* Split a comma-separated env value into at most MAX_LIST strings; the
+   value is strdup'd so the returned pointers stay valid. */
+static int
+split_list(const char *value, const char *items[]) {
+    char *copy = strdup(value);
+    char *tok = NULL;
+    int n = 0;
+
+    for (tok = strtok(copy, ","); tok != NULL && n < MAX_LIST;
+         tok = strtok(NULL, ","))
+        items[n++] = tok;
+    return n;
+}
+
+static int
+env_count(const char *name, int fallback) {
+    const char *value = getenv(name);
+    if (value != NULL && atoi(value) > 0)
+        return atoi(value);
+    return fallback;
+}
+
+static int
+compare_doubles(const void *a, const void *b) {
+    const double x = *(const double *) a;
+    const double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/* One CSV row: run the current GOL_ENGINE/GOL_NUM_THREADS setting reps
+   times on a fresh copy of the pristine board each time. */
+static void
+bench_one(const char *engine, const char *infilename, const char *pristine,
+          char *inboard, char *outboard, const int nrows, const int ncols,
+          const int gens_max, const int nthreads,
+          const int warmup, const int reps) {
+    double times[MAX_LIST];
+    double mean = 0.0;
+    double var = 0.0;
+    double median = 0.0;
+    int r;
+
+    for (r = 0; r < warmup + reps; r++) {
+        double start;
+        memcpy(inboard, pristine, (size_t) nrows * ncols);
+        start = now_seconds();
+        game_of_life(outboard, inboard, nrows, ncols, gens_max);
+        if (r >= warmup)
+            times[r - warmup] = now_seconds() - start;
+    }
+
+    qsort(times, reps, sizeof(double), compare_doubles);
+    median = (reps % 2 == 1) ? times[reps / 2]
+                             : 0.5 * (times[reps / 2 - 1] + times[reps / 2]);
+    for (r = 0; r < reps; r++)
+        mean += times[r] / reps;
+    for (r = 0; r < reps; r++)
+        var += (times[r] - mean) * (times[r] - mean) / reps;
+
+    printf("%s,%s,%d,%d,%d,%d,%d,%.3f,%.3f,%.3e\n",
+           engine, infilename, nrows, ncols, nthreads, gens_max, reps,
+           1.0e3 * median, 1.0e3 * sqrt(var),
+           (double) nrows * ncols * gens_max / (median > 0.0 ? median : 1.0e-9));
+    fflush(stdout);
+}
+
+int
+main(int argc, char *argv[]) {
+    const char *engines[MAX_LIST];
+    const char *threads[MAX_LIST];
+    int nengines = 0;
+    int nthread_counts = 0;
+    int gens_max = 0;
+    int warmup, reps;
+    int e, t, f;
+
+    if (argc < 3) {
+        fprintf(stderr, "*** Need a generation count and at least one board ***\n");
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    errno = 0;
+    gens_max = strtol(argv[1], NULL, 10);
+    if (errno != 0 || gens_max < 0) {
+        fprintf(stderr, "*** <num_generations> argument \'%s\' "
+                "must be a nonnegative integer! ***\n", argv[1]);
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    nengines = split_list(getenv("GOL_BENCH_ENGINES") != NULL
+                                  ? getenv("GOL_BENCH_ENGINES")
+                                  : "seq,parallel,tile,bit,sparse,stream",
+                          engines);
+    if (getenv("GOL_BENCH_THREADS") != NULL) {
+        nthread_counts = split_list(getenv("GOL_BENCH_THREADS"), threads);
+    }
+    else {
+        static char default_threads[16];
+        snprintf(default_threads, sizeof(default_threads), "%d",
+                 gol_num_threads());
+        threads[0] = default_threads;
+        nthread_counts = 1;
+    }
+    warmup = env_count("GOL_BENCH_WARMUP", 1);
+    reps = env_count("GOL_BENCH_REPS", 5);
+    if (reps > MAX_LIST)
+        reps = MAX_LIST;
+
+    printf("engine,input,nrows,ncols,threads,gens,reps,"
+           "median_ms,stddev_ms,cells_per_sec\n");
+
+    for (f = 2; f < argc; f++) {
+        FILE *input = fopen(argv[f], "r");
+        char *pristine = NULL;
+        char *inboard = NULL;
+        char *outboard = NULL;
+        int nrows = 0;
+        int ncols = 0;
+
+        if (input == NULL) {
+            fprintf(stderr, "*** Failed to open input file \'%s\' for reading! ***\n",
+                    argv[f]);
+            exit(EXIT_FAILURE);
+        }
+        pristine = load_board(input, &nrows, &ncols);
+        fclose(input);
+        inboard = make_board(nrows, ncols);
+        outboard = make_board(nrows, ncols);
+
+        for (e = 0; e < nengines; e++) {
+            setenv("GOL_ENGINE", engines[e], 1);
+            for (t = 0; t < nthread_counts; t++) {
+                setenv("GOL_NUM_THREADS", threads[t], 1);
+                bench_one(engines[e], argv[f], pristine, inboard, outboard,
+                          nrows, ncols, gens_max, atoi(threads[t]),
+                          warmup, reps);
+            }
+        }
+
+        free(pristine);
+        free(inboard);
+        free(outboard);
+    }
+
+    return 0;
+}
@@ -1,9 +1,53 @@
 #include <assert.h>
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
 #include "random_bit.h"
+#include "save.h"
+
+//Arguments handed to each board-filling thread.
+struct fill_argument_t {
+    char *board;
+    long start;
+    long end;
+    uint64_t state; /* private PRNG stream */
+};
+
+static void *
+fill_worker(void *args) {
+    struct fill_argument_t *arg = (struct fill_argument_t *) args;
+    char *board = arg->board;
+    long k = arg->start;
+
+    /* draw 64 cells per PRNG call instead of one */
+    while (k < arg->end) {
+        uint64_t word = random_bit_word(&arg->state);
+        long stop = (arg->end - k < 64) ? arg->end : k + 64;
+        for (; k < stop; k++) {
+            board[k] = (char) (word & 1);
+            word >>= 1;
+        }
+    }
+    return NULL;
+}
+
+static int
+num_fill_threads(void) {
+    /* same convention as the gol engines: GOL_NUM_THREADS when set,
+       otherwise the number of online CPUs */
+    const char *env = getenv("GOL_NUM_THREADS");
+    int nthreads = 0;
+    if (env != NULL)
+        nthreads = atoi(env);
+    if (nthreads < 1)
+        nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads < 1)
+        nthreads = 1;
+    return nthreads;
+}
 
 static int
 to_int(int *num, const char *s) {
@@ -25,10 +69,12 @@ print_usage(const char argv0[]) {
 int
 main(int argc, char *argv[]) {
     const int verbose = 0;
-    int ii, jj, nrows, ncols;
+    int nrows, ncols;
     int err = 0;
+    uint32_t seed;
 
-    init_random_bit(get_random_seed());
+    seed = get_random_seed();
+    init_random_bit(seed);
 
     if (argc != 3) {
         fprintf(stderr, "Incorrect number of command-line arguments!\n");
@@ -65,10 +111,38 @@ main(int argc, char *argv[]) {
                        "Number of cols: %d\n",
                nrows, ncols);
 
-    printf("P1\n%d %d\n", nrows, ncols);
-    for (ii = 0; ii < nrows; ii++)
-        for (jj = 0; jj < ncols; jj++)
-            printf("%c\n", '0' + random_bit());
+    {
+        /* Fill a whole board in parallel, one decorrelated PRNG stream
+           per thread, then hand it to the buffered board writer (which
+           also honours GOL_OUTPUT_FORMAT, e.g. the binary format). */
+        const long total = (long) nrows * ncols;
+        int nthreads = num_fill_threads();
+        char *board = malloc(total * sizeof(char));
+        struct fill_argument_t *args = malloc(nthreads * sizeof(struct fill_argument_t));
+        pthread_t *threads = malloc(nthreads * sizeof(pthread_t));
+        int i;
+
+        if (board == NULL || args == NULL || threads == NULL) {
+            fprintf(stderr, "*** Failed to allocate board buffers ***\n");
+            exit(EXIT_FAILURE);
+        }
+        for (i = 0; i < nthreads; i++) {
+            args[i].board = board;
+            args[i].start = i * total / nthreads;
+            args[i].end = (i + 1) * total / nthreads;
+            init_random_bit_stream(&args[i].state, seed, i);
+            if (i > 0)
+                pthread_create(&threads[i], NULL, fill_worker, &args[i]);
+        }
+        fill_worker(&args[0]);
+        for (i = 1; i < nthreads; i++)
+            pthread_join(threads[i], NULL);
+
+        save_board(stdout, board, nrows, ncols);
+        free(board);
+        free(args);
+        free(threads);
+    }
 
     return 0;
 }
@@ -0,0 +1,156 @@
+/*****************************************************************************
+ * checkpoint.c
+ * Periodic snapshot/restart support for long simulations.  Snapshots are
+ * bit-packed like the GOLB board format plus a generation counter, staged
+ * in memory and written by a background thread, and renamed into place so
+ * the previous checkpoint survives a crash mid-write.
+ ****************************************************************************/
+#include "checkpoint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECKPOINT_MAGIC "GOLC"
+#define CHECKPOINT_MAGIC_LEN 4
+#define CHECKPOINT_HEADER_LEN (CHECKPOINT_MAGIC_LEN + 3 * sizeof(int))
+
+static void *
+checkpoint_writer_thread(void *args) {
+    struct checkpoint_writer_t *w = (struct checkpoint_writer_t *) args;
+    const size_t colbytes = ((size_t) w->nrows + 7) / 8;
+    const size_t total = CHECKPOINT_HEADER_LEN + colbytes * w->ncols;
+    unsigned char *bytes = NULL;
+    char *tmppath = NULL;
+    FILE *out = NULL;
+    int i, j;
+
+    bytes = calloc(total, 1);
+    tmppath = malloc(strlen(w->path) + sizeof(".tmp"));
+    if (bytes == NULL || tmppath == NULL) {
+        fprintf(stderr, "*** Failed to allocate checkpoint image ***\n");
+        exit(EXIT_FAILURE);
+    }
+    sprintf(tmppath, "%s.tmp", w->path);
+
+    memcpy(bytes, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LEN);
+    memcpy(bytes + CHECKPOINT_MAGIC_LEN, &w->gens_done, sizeof(int));
+    memcpy(bytes + CHECKPOINT_MAGIC_LEN + sizeof(int), &w->nrows, sizeof(int));
+    memcpy(bytes + CHECKPOINT_MAGIC_LEN + 2 * sizeof(int), &w->ncols, sizeof(int));
+    for (j = 0; j < w->ncols; j++) {
+        const char *src = w->staging + (size_t) j * w->nrows;
+        unsigned char *dst = bytes + CHECKPOINT_HEADER_LEN + j * colbytes;
+        for (i = 0; i < w->nrows; i++)
+            dst[i >> 3] |= (unsigned char) (src[i] & 1) << (i & 7);
+    }
+
+    out = fopen(tmppath, "wb");
+    if (out == NULL || fwrite(bytes, 1, total, out) != total || fclose(out) != 0) {
+        fprintf(stderr, "*** Failed to write checkpoint \'%s\' ***\n", tmppath);
+        exit(EXIT_FAILURE);
+    }
+    if (rename(tmppath, w->path) != 0) {
+        fprintf(stderr, "*** Failed to move checkpoint into place ***\n");
+        exit(EXIT_FAILURE);
+    }
+
+    free(bytes);
+    free(tmppath);
+    return NULL;
+}
+
+void
+checkpoint_writer_init(struct checkpoint_writer_t *w, const char *path,
+                       int nrows, int ncols) {
+    w->path = path;
+    w->nrows = nrows;
+    w->ncols = ncols;
+    w->active = 0;
+    w->staging = malloc((size_t) nrows * ncols * sizeof(char));
+    if (w->staging == NULL) {
+        fprintf(stderr, "*** Failed to allocate checkpoint staging board ***\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void
+checkpoint_write(struct checkpoint_writer_t *w, const char *board,
+                 int gens_done) {
+    if (w->active)
+        pthread_join(w->thread, NULL);
+    memcpy(w->staging, board, (size_t) w->nrows * w->ncols * sizeof(char));
+    w->gens_done = gens_done;
+    pthread_create(&w->thread, NULL, checkpoint_writer_thread, w);
+    w->active = 1;
+}
+
+void
+checkpoint_writer_destroy(struct checkpoint_writer_t *w) {
+    if (w->active)
+        pthread_join(w->thread, NULL);
+    w->active = 0;
+    free(w->staging);
+    w->staging = NULL;
+}
+
+int
+checkpoint_try_load(const char *path, char *board, int nrows, int ncols,
+                    int gens_max) {
+    const size_t colbytes = ((size_t) nrows + 7) / 8;
+    unsigned char header[CHECKPOINT_HEADER_LEN];
+    unsigned char *body = NULL;
+    FILE *in = NULL;
+    int gens_done, cknrows, ckncols;
+    int i, j;
+
+    in = fopen(path, "rb");
+    if (in == NULL)
+        return 0; /* no checkpoint yet: fresh start */
+    if (fread(header, 1, sizeof(header), in) != sizeof(header) ||
+        memcmp(header, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LEN) != 0) {
+        fprintf(stderr, "*** Ignoring malformed checkpoint \'%s\' ***\n", path);
+        fclose(in);
+        return 0;
+    }
+    memcpy(&gens_done, header + CHECKPOINT_MAGIC_LEN, sizeof(int));
+    memcpy(&cknrows, header + CHECKPOINT_MAGIC_LEN + sizeof(int), sizeof(int));
+    memcpy(&ckncols, header + CHECKPOINT_MAGIC_LEN + 2 * sizeof(int), sizeof(int));
+    if (cknrows != nrows || ckncols != ncols || gens_done < 1) {
+        fprintf(stderr, "*** Ignoring checkpoint \'%s\': %dx%d does not match "
+                        "the %dx%d input board ***\n",
+                path, cknrows, ckncols, nrows, ncols);
+        fclose(in);
+        return 0;
+    }
+    if (gens_done > gens_max) {
+        /* a board cannot be rewound, so a snapshot from a longer run is
+           no use for this one */
+        fprintf(stderr, "*** Ignoring checkpoint \'%s\': already at generation "
+                        "%d, past the requested %d ***\n",
+                path, gens_done, gens_max);
+        fclose(in);
+        return 0;
+    }
+
+    /* slurp the whole body before touching board, so a truncated file
+       leaves the caller's initial state intact */
+    body = malloc(colbytes * ncols);
+    if (body == NULL) {
+        fprintf(stderr, "*** Failed to allocate checkpoint image ***\n");
+        exit(EXIT_FAILURE);
+    }
+    if (fread(body, 1, colbytes * ncols, in) != colbytes * ncols) {
+        fprintf(stderr, "*** Ignoring truncated checkpoint \'%s\' ***\n", path);
+        free(body);
+        fclose(in);
+        return 0;
+    }
+    for (j = 0; j < ncols; j++) {
+        const unsigned char *src = body + j * colbytes;
+        char *dst = board + (size_t) j * nrows;
+        for (i = 0; i < nrows; i++)
+            dst[i] = (src[i >> 3] >> (i & 7)) & 1;
+    }
+    free(body);
+    fclose(in);
+    return gens_done;
+}
@@ -0,0 +1,54 @@
+#ifndef _checkpoint_h
+#define _checkpoint_h
+
+#include <pthread.h>
+
+/**
+ * Periodic checkpoint support for long runs.  When the GOL_CHECKPOINT
+ * environment variable names a file, game_of_life() snapshots the board
+ * there every GOL_CHECKPOINT_INTERVAL generations (default 1000) and
+ * resumes from the snapshot on the next run with the same file.
+ *
+ * Snapshot format: "GOLC" magic, then the generation count, nrows and
+ * ncols as native ints, then the cells packed eight per byte column-major
+ * as in the GOLB board format.  Snapshots are written to a temporary file
+ * and renamed, so a crash mid-write never corrupts the previous one.
+ */
+
+/**
+ * Hands snapshots to a background thread so the engine never stalls on
+ * disk: checkpoint_write() copies the board into the staging buffer and
+ * returns; the write and atomic rename happen off the critical path.
+ */
+struct checkpoint_writer_t {
+    const char *path;
+    char *staging;      /* board copy the writer thread packs from */
+    int nrows;
+    int ncols;
+    int gens_done;
+    int active;         /* a writer thread is in flight */
+    pthread_t thread;
+};
+
+void checkpoint_writer_init(struct checkpoint_writer_t *w, const char *path,
+                            int nrows, int ncols);
+
+/**
+ * Snapshot the board as of generation gens_done.  Blocks only if the
+ * previous snapshot is still being written.
+ */
+void checkpoint_write(struct checkpoint_writer_t *w, const char *board,
+                      int gens_done);
+
+/** Wait for the last snapshot to land and release the staging buffer. */
+void checkpoint_writer_destroy(struct checkpoint_writer_t *w);
+
+/**
+ * If path holds a snapshot matching nrows x ncols whose generation count
+ * does not exceed gens_max, load it into board and return its generation
+ * count; otherwise leave board alone and return 0.
+ */
+int checkpoint_try_load(const char *path, char *board, int nrows, int ncols,
+                        int gens_max);
+
+#endif /* _checkpoint_h */
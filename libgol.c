@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * libgol.c
+ * Context API for embedding the engines (see libgol.h).  A context is a
+ * persistent worker pool plus an optional observer; evolution runs in
+ * observer-interval chunks through gol_evolve(), whose decoded board
+ * between chunks is exactly the read-only view the observer is handed.
+ ****************************************************************************/
+#include "libgol.h"
+#include "life.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+struct gol_context_t {
+    struct gol_pool_t *pool;
+    gol_observer_t observer;
+    int interval;
+    void *user;
+};
+
+struct gol_context_t *
+gol_context_create(int nthreads) {
+    struct gol_context_t *context = malloc(sizeof(struct gol_context_t));
+
+    if (context == NULL) {
+        fprintf(stderr, "*** Failed to allocate context ***\n");
+        exit(EXIT_FAILURE);
+    }
+    context->pool = gol_pool_create(nthreads);
+    context->observer = NULL;
+    context->interval = 1;
+    context->user = NULL;
+    return context;
+}
+
+void
+gol_context_set_observer(struct gol_context_t *context,
+                         gol_observer_t observer, int interval, void *user) {
+    context->observer = observer;
+    context->interval = (interval < 1) ? 1 : interval;
+    context->user = user;
+}
+
+char *
+gol_context_evolve(struct gol_context_t *context, char *outboard,
+                   char *inboard, const int nrows, const int ncols,
+                   const int gens_max) {
+    char *cur = inboard;
+    char *spare = outboard;
+    int gens_done = 0;
+
+    if (context->observer == NULL)
+        return gol_evolve(context->pool, outboard, inboard,
+                          nrows, ncols, gens_max);
+
+    /* Same chunk loop as the checkpointed path in game_of_life(): the
+       engine runs unobserved for one interval, and between chunks cur
+       holds the plain 0/1 board, so the observer reads it in place. */
+    while (gens_done < gens_max) {
+        int chunk = gens_max - gens_done;
+        if (chunk > context->interval)
+            chunk = context->interval;
+        cur = gol_evolve(context->pool, spare, cur, nrows, ncols, chunk);
+        spare = (cur == outboard) ? inboard : outboard;
+        gens_done += chunk;
+        context->observer(cur, nrows, ncols, gens_done, context->user);
+    }
+    return cur;
+}
+
+void
+gol_context_destroy(struct gol_context_t *context) {
+    gol_pool_destroy(context->pool);
+    free(context);
+}
@@ -0,0 +1,50 @@
+#ifndef _libgol_h
+#define _libgol_h
+
+/**
+ * Embedding API for the game of life engines, built as libgol.a ("make
+ * lib").  A context owns a persistent worker pool, so evolving many
+ * boards through one context costs no thread startup per board; the
+ * optional observer gets a read-only view of the live board between
+ * generations without any copying, which replaces the dump-to-disk /
+ * re-parse pipeline external visualizers used so far.
+ *
+ * Board format is the same as the rest of the tree: one char per cell,
+ * 0 or 1, column-major.  The I/O helpers (load_board, make_board,
+ * save_board) live in load.h and save.h.
+ */
+
+struct gol_context_t;
+
+/**
+ * Called every observation interval with the board as it stands after
+ * generation gen (1-based).  The pointer aliases the context's working
+ * board: read it during the callback only, and do not write through it.
+ */
+typedef void (*gol_observer_t)(const char *board, int nrows, int ncols,
+                               int gen, void *user);
+
+/** Create a context over nthreads pinned workers (0 means the default). */
+struct gol_context_t *gol_context_create(int nthreads);
+
+/**
+ * Install an observer called every interval generations (1 = every
+ * generation).  Pass observer == NULL to remove it again.
+ */
+void gol_context_set_observer(struct gol_context_t *context,
+                              gol_observer_t observer, int interval,
+                              void *user);
+
+/**
+ * Evolve inboard gens_max generations, ping-ponging with outboard like
+ * game_of_life(), and return the final board (either of the two
+ * pointers).  Not reentrant: one job runs on a context at a time.
+ */
+char *gol_context_evolve(struct gol_context_t *context, char *outboard,
+                         char *inboard, const int nrows, const int ncols,
+                         const int gens_max);
+
+/** Shut the workers down and free the context. */
+void gol_context_destroy(struct gol_context_t *context);
+
+#endif /* _libgol_h */
@@ -2,6 +2,7 @@
 #define _life_h
 
 #include <pthread.h>
+#include <sched.h>
 
 /**
  * Given the initial board state in inboard and the board dimensions
@@ -11,9 +12,8 @@
  * inboard (but you don't know which).
  */
 
-int LDA;
+extern int LDA;
 #define BOARD(__board, __i, __j)  (__board[(__i) + LDA*(__j)])
-#define NUM_THREADS 8
 
 #define SWAP_BOARDS(b1, b2)  do { \
   char* temp = b1; \
@@ -29,11 +29,200 @@ int LDA;
 #define N_INC(__board, __i, __j) (BOARD(__board, __i, __j) += 1)
 #define N_DEC(__board, __i, __j) (BOARD(__board, __i, __j) -= 1)
 
-void do_cell(char *outboard, char *inboard, int i, int j, const int size);
-void kill_cell(char *outboard, int i, int j, const int size);
-void spawn_cell(char *outboard, int i, int j, const int size);
-void preprocessing_board(char *inboard, char *outboard, int size);
-inline void postprocessing_board(char *board, int nrows, int ncols);
+/**
+ * Number of worker threads the parallel engines size their pools to:
+ * the GOL_NUM_THREADS environment variable when set to a positive
+ * number, otherwise the number of online CPUs.  Engines may clamp this
+ * further to fit the board geometry.
+ */
+int gol_num_threads(void);
+
+/**
+ * Pin the ith worker to a core (round robin over the online CPUs) so
+ * its slice stays resident in that core's private caches.
+ */
+void gol_pin_thread(pthread_t thread, int ith);
+
+/**
+ * Hybrid spin-then-yield sense-reversing barrier for the row-slice
+ * engine.  On small boards a generation takes single-digit microseconds
+ * per thread while a pthread_barrier_wait() wakeup goes through the
+ * kernel futex path and costs tens, so when the per-thread work is tiny
+ * (and the cores are not oversubscribed) arrivals spin on a shared sense
+ * flag with a pause hint and only start yielding the CPU once the spin
+ * budget runs out.  With spin off it degrades to pthread_barrier_wait().
+ */
+#define GOL_BARRIER_SPINS 4096
+
+struct gol_barrier_t {
+    pthread_barrier_t fallback;
+    volatile int count;
+    volatile int sense;
+    int nthreads;
+    int spin;
+};
+
+static inline void
+gol_barrier_init(struct gol_barrier_t *barrier, int nthreads, int spin) {
+    pthread_barrier_init(&barrier->fallback, NULL, nthreads);
+    barrier->count = 0;
+    barrier->sense = 0;
+    barrier->nthreads = nthreads;
+    barrier->spin = spin;
+}
+
+static inline void
+gol_barrier_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ __volatile__("pause");
+#endif
+}
+
+/**
+ * local_sense is one int per participating thread, initialized to 0; it
+ * flips on every wait so consecutive barriers cannot be confused.
+ */
+static inline void
+gol_barrier_wait(struct gol_barrier_t *barrier, int *local_sense) {
+    int sense;
+    long spins = 0;
+
+    if (!barrier->spin) {
+        pthread_barrier_wait(&barrier->fallback);
+        return;
+    }
+    sense = !*local_sense;
+    *local_sense = sense;
+    if (__sync_add_and_fetch(&barrier->count, 1) == barrier->nthreads) {
+        /* last arrival: reset the count for the next round, then flip
+           the shared sense to release everyone */
+        barrier->count = 0;
+        __sync_synchronize();
+        barrier->sense = sense;
+    }
+    else {
+        while (barrier->sense != sense) {
+            if (++spins > GOL_BARRIER_SPINS)
+                sched_yield();
+            else
+                gol_barrier_cpu_relax();
+        }
+        __sync_synchronize();
+    }
+}
+
+static inline void
+gol_barrier_destroy(struct gol_barrier_t *barrier) {
+    pthread_barrier_destroy(&barrier->fallback);
+}
+
+/**
+ * Instrumentation for the parallel engine, compiled in with
+ * "make STATS=1" (which defines GOL_STATS) and costing nothing
+ * otherwise.  Per-thread totals over a whole gol_evolve() call; a
+ * summary table is printed to stderr when the call returns.
+ */
+#ifdef GOL_STATS
+struct gol_stats_t {
+    long long cells_examined;  /* slice cells visited, all generations */
+    long long cells_changed;   /* cells toggled */
+    long long copy_fallbacks;  /* generations whose change list overflowed */
+    long long barrier_wait_ns; /* time spent parked in barrier waits */
+};
+#define GOL_STAT_ADD(arg, field, n) ((arg)->stats.field += (n))
+#else
+#define GOL_STAT_ADD(arg, field, n) ((void) 0)
+#endif
+
+//This data structure contains all arguments needed
+//by the worker function.
+struct thread_argument_t {
+    char *outboard;
+    char *inboard;
+    int nrows;
+    int ncols;
+    int ith_slice;
+    int nthreads;
+    int gens_max;
+    struct gol_barrier_t *barrier;
+    /* Private halo rows: neighbour-count deltas aimed at the row just
+       outside the slice are accumulated here instead of being written
+       into the neighbouring slice, and merged once per generation. */
+    signed char *halo_north; /* deltas for the row above our slice */
+    signed char *halo_south; /* deltas for the row below our slice */
+    signed char *neighbor_halo_south; /* upper neighbour's deltas for our first row */
+    signed char *neighbor_halo_north; /* lower neighbour's deltas for our last row */
+    /* Change list: (i, j) pairs of the cells this thread toggled during
+       the current generation, replayed on the input board instead of
+       copying the whole slice back.  If more than max_changes cells
+       toggle, the generation falls back to a bulk copy of the slice. */
+    int *changes;
+    int max_changes;
+    /* Rolling hash of every (generation, i, j) toggle this thread made;
+       XOR-combined across threads into gol_trace_hash, so a divergence
+       in any generation changes the final value. */
+    unsigned long long toggle_hash;
+    /* Early termination (GOL_EARLY_STOP): two shared flags indexed by
+       generation parity; a thread that toggled anything sets this
+       generation's flag before the first barrier, and if it is still
+       clear afterwards the board is a still life and every thread breaks
+       out.  NULL when the mode is off. */
+    volatile int *changed_flags;
+    int early_stop;
+    int gens_done; /* out: generations actually evolved */
+#ifdef GOL_STATS
+    struct gol_stats_t stats;
+#endif
+};
+
+/**
+ * Toggle-trace hash of the last gol_evolve() call: one 64-bit value
+ * covering every cell toggle of every generation.  The verify build can
+ * compare it against a recorded reference instead of re-running the
+ * whole simulation sequentially (see gol.c).  Zero for engines that do
+ * not produce a trace.
+ */
+extern unsigned long long gol_trace_hash;
+
+/**
+ * Generations the last run actually evolved: equal to its gens_max
+ * unless the run ended at a still life first (opted into with
+ * GOL_EARLY_STOP for the row-slice engine; the sparse engine always
+ * stops there and reports it here).
+ */
+extern int gol_gens_run;
+
+/**
+ * Persistent worker pool for callers that evolve many boards in one
+ * process: the workers are created and pinned once and parked on a
+ * condition variable between calls, so gol_evolve() costs no thread
+ * creation or teardown.  parallel_game_of_life() is a one-shot wrapper
+ * over a process-wide pool.  Lives in life_pool.c.
+ */
+struct gol_pool_t;
+
+/** Create a parked pool of nthreads workers (0 means the default count). */
+struct gol_pool_t *gol_pool_create(int nthreads);
+
+/**
+ * Evolve one board on the pool, same contract as game_of_life().  Not
+ * reentrant: one job runs on a pool at a time.
+ */
+char *gol_evolve(struct gol_pool_t *pool, char *outboard, char *inboard,
+                 const int nrows, const int ncols, const int gens_max);
+
+/** Shut the workers down and free the pool. */
+void gol_pool_destroy(struct gol_pool_t *pool);
+
+void do_cell(char *outboard, char *inboard, int i, int j,
+             const int nrows, const int ncols);
+void kill_cell(char *outboard, int i, int j,
+               const int nrows, const int ncols);
+void spawn_cell(char *outboard, int i, int j,
+                const int nrows, const int ncols);
+void preprocessing_board(char *inboard, char *outboard, int nrows, int ncols);
+void encode_board(char *inboard, int nrows, int ncols);
+void postprocessing_board(char *board, int nrows, int ncols);
 void *worker_fuction_by_rows_encoding(void *args);
 
 char *
@@ -65,5 +254,75 @@ char *
                               const int gens_max
 );
 
+/**
+ * Tiled version of GOL: same encoded-board scheme as
+ * parallel_game_of_life(), but decomposed into tiles handed out through
+ * work-stealing deques so load balances with the population, not the
+ * geometry.  Lives in life_tile.c.
+ * */
+char *
+        tile_game_of_life(char *outboard,
+                          char *inboard,
+                          const int nrows,
+                          const int ncols,
+                          const int gens_max
+);
+
+/**
+ * Sparse version of GOL: visits only the cells that can change state,
+ * chosen by game_of_life() when the live-cell density is low.  Falls
+ * back to the tile engine if the board stops being sparse.  Lives in
+ * life_sparse.c.
+ * */
+char *
+        sparse_game_of_life(char *outboard,
+                            char *inboard,
+                            const int nrows,
+                            const int ncols,
+                            const int gens_max
+);
+
+/**
+ * Hashlife version of GOL: memoized quadtree with canonicalized nodes
+ * that jumps power-of-two generation counts, so repetitive patterns
+ * evolved for huge gens_max cost far less than gens_max * cells.  Works
+ * in place on inboard and returns it.  Lives in life_hashlife.c.
+ * */
+char *
+        hashlife_game_of_life(char *outboard,
+                              char *inboard,
+                              const int nrows,
+                              const int ncols,
+                              const int gens_max
+);
+
+/**
+ * Streaming version of GOL: evolves the board in place one band of
+ * columns at a time, stashing band-edge columns between barriers, so the
+ * per-thread working set is a few columns regardless of board size.
+ * Chosen by game_of_life() for boards beyond the dense engines' limit.
+ * Lives in life_stream.c.
+ * */
+char *
+        stream_game_of_life(char *outboard,
+                            char *inboard,
+                            const int nrows,
+                            const int ncols,
+                            const int gens_max
+);
+
+/**
+ * Bit-packed version of GOL: 64 cells per uint64_t, next-generation state
+ * computed with word-parallel bitwise adders (AVX2 when available).  Same
+ * 0/1 board format as the other engines.  Lives in life_bit.c.
+ * */
+char *
+        bit_game_of_life(char *outboard,
+                         char *inboard,
+                         const int nrows,
+                         const int ncols,
+                         const int gens_max
+);
+
 
 #endif /* _life_h */
@@ -0,0 +1,460 @@
+/*****************************************************************************
+ * life_hashlife.c
+ * Memoized quadtree ("hashlife") implementation of the game of life.
+ * Nodes are canonicalized in a hash table, so identical regions of space
+ * share one subtree, and each node caches its evolved center, so identical
+ * regions of spacetime are computed once.  Generations are consumed in
+ * power-of-two jumps; repetitive patterns evolve exponentially faster than
+ * any per-cell engine can manage.
+ *
+ * Toroidal wraparound: a torus evolved t generations equals the infinite
+ * plane tiled periodically with the board, evolved t generations, read
+ * back through any aligned window.  The tree is therefore built over the
+ * periodic plane (coordinates taken mod the board size), which the
+ * canonicalization compresses massively, and the board window is extracted
+ * again after every jump.
+ ****************************************************************************/
+#include "life.h"
+#include "util.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A level-l node covers a 2^l x 2^l window; level 0 is a single cell.
+   result caches the center advanced by a full 2^(level-2) step. */
+struct qnode_t {
+    struct qnode_t *nw, *ne, *sw, *se;
+    struct qnode_t *result;
+    struct qnode_t *hash_next;
+    int level;
+};
+
+/* memo for advance() with a step smaller than the node's full step */
+struct step_memo_t {
+    const struct qnode_t *node;
+    int b;
+    struct qnode_t *result;
+    struct step_memo_t *hash_next;
+};
+
+/* memo for build(): the periodic plane repeats, so a window is determined
+   by (level, row offset mod nrows, col offset mod ncols).  Entries are
+   invalidated wholesale by bumping the version when the board changes. */
+struct build_memo_t {
+    int level;
+    int x, y;
+    unsigned version;
+    struct qnode_t *node;
+};
+
+#define QNODE_HASH_BITS 20
+#define STEP_HASH_BITS 16
+#define QNODE_ARENA_CHUNK (1 << 16)
+/* past this many nodes the universe is scrapped and rebuilt; cached
+   results are lost but the flat board carries all the state that matters */
+#define QNODE_MAX_NODES (1 << 22)
+
+struct universe_t {
+    struct qnode_t **table;
+    struct step_memo_t **step_table;
+    struct qnode_t *arena; /* current chunk */
+    int arena_used;
+    void **chunks; /* every chunk, for freeing */
+    int nchunks, max_chunks;
+    long nnodes;
+    struct qnode_t *dead_leaf;
+    struct qnode_t *alive_leaf;
+    struct qnode_t **empties; /* canonical all-dead node per level */
+    int max_level;
+    /* build state */
+    const char *board;
+    int nrows, ncols;
+    struct build_memo_t *build_memo;
+    int build_memo_size;
+    unsigned build_version;
+};
+
+static void *
+xmalloc(size_t bytes) {
+    void *p = malloc(bytes);
+    if (p == NULL) {
+        fprintf(stderr, "*** Out of memory in hashlife engine ***\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+static struct qnode_t *
+qnode_alloc(struct universe_t *u) {
+    if (u->arena == NULL || u->arena_used == QNODE_ARENA_CHUNK) {
+        if (u->nchunks == u->max_chunks) {
+            u->max_chunks = u->max_chunks ? 2 * u->max_chunks : 16;
+            u->chunks = realloc(u->chunks, u->max_chunks * sizeof(void *));
+            if (u->chunks == NULL) {
+                fprintf(stderr, "*** Out of memory in hashlife engine ***\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        u->arena = xmalloc(QNODE_ARENA_CHUNK * sizeof(struct qnode_t));
+        u->chunks[u->nchunks++] = u->arena;
+        u->arena_used = 0;
+    }
+    u->nnodes++;
+    return &u->arena[u->arena_used++];
+}
+
+static uint64_t
+qnode_hash(const struct qnode_t *nw, const struct qnode_t *ne,
+           const struct qnode_t *sw, const struct qnode_t *se) {
+    uint64_t h = (uintptr_t) nw * 0x9e3779b97f4a7c15ULL;
+    h ^= (uintptr_t) ne * 0xc2b2ae3d27d4eb4fULL;
+    h ^= (uintptr_t) sw * 0x165667b19e3779f9ULL;
+    h ^= (uintptr_t) se * 0x27d4eb2f165667c5ULL;
+    return h ^ (h >> 29);
+}
+
+/**
+ * The canonicalizing constructor: one node per distinct (nw,ne,sw,se).
+ */
+static struct qnode_t *
+find_node(struct universe_t *u, struct qnode_t *nw, struct qnode_t *ne,
+          struct qnode_t *sw, struct qnode_t *se) {
+    uint64_t slot = qnode_hash(nw, ne, sw, se) & ((1u << QNODE_HASH_BITS) - 1);
+    struct qnode_t *n;
+
+    for (n = u->table[slot]; n != NULL; n = n->hash_next) {
+        if (n->nw == nw && n->ne == ne && n->sw == sw && n->se == se)
+            return n;
+    }
+    n = qnode_alloc(u);
+    n->nw = nw;
+    n->ne = ne;
+    n->sw = sw;
+    n->se = se;
+    n->result = NULL;
+    n->level = nw->level + 1;
+    n->hash_next = u->table[slot];
+    u->table[slot] = n;
+    return n;
+}
+
+static struct qnode_t *
+center_node(struct universe_t *u, const struct qnode_t *n) {
+    return find_node(u, n->nw->se, n->ne->sw, n->sw->ne, n->se->nw);
+}
+
+/* a left of b */
+static struct qnode_t *
+horizontal_node(struct universe_t *u, const struct qnode_t *a, const struct qnode_t *b) {
+    return find_node(u, a->ne, b->nw, a->se, b->sw);
+}
+
+/* a above b */
+static struct qnode_t *
+vertical_node(struct universe_t *u, const struct qnode_t *a, const struct qnode_t *b) {
+    return find_node(u, a->sw, a->se, b->nw, b->ne);
+}
+
+/**
+ * Base case: one generation of the 4x4 node, computed by brute force,
+ * yielding its 2x2 center.
+ */
+static struct qnode_t *
+step_level2(struct universe_t *u, const struct qnode_t *n) {
+    char cells[4][4];
+    char next[2][2];
+    int r, c;
+
+    for (r = 0; r < 4; r++) {
+        for (c = 0; c < 4; c++) {
+            const struct qnode_t *q = (r < 2) ? ((c < 2) ? n->nw : n->ne)
+                                              : ((c < 2) ? n->sw : n->se);
+            const struct qnode_t *leaf = (r % 2 == 0)
+                    ? ((c % 2 == 0) ? q->nw : q->ne)
+                    : ((c % 2 == 0) ? q->sw : q->se);
+            cells[r][c] = (leaf == u->alive_leaf);
+        }
+    }
+    for (r = 1; r <= 2; r++) {
+        for (c = 1; c <= 2; c++) {
+            char count = cells[r - 1][c - 1] + cells[r - 1][c] + cells[r - 1][c + 1]
+                       + cells[r][c - 1] + cells[r][c + 1]
+                       + cells[r + 1][c - 1] + cells[r + 1][c] + cells[r + 1][c + 1];
+            next[r - 1][c - 1] = alivep(count, cells[r][c]);
+        }
+    }
+#define LEAF(v) ((v) ? u->alive_leaf : u->dead_leaf)
+    return find_node(u, LEAF(next[0][0]), LEAF(next[0][1]),
+                     LEAF(next[1][0]), LEAF(next[1][1]));
+#undef LEAF
+}
+
+/**
+ * Advance a node 2^b generations (b <= level-2), returning its center at
+ * level-1.  When b == level-2 this is the classic memoized full step,
+ * cached on the node; smaller steps recurse through the sub-centers with
+ * no evolution in the second layer, cached in the step memo.
+ */
+static struct qnode_t *
+advance(struct universe_t *u, struct qnode_t *n, int b) {
+    struct qnode_t *t00, *t01, *t02, *t10, *t11, *t12, *t20, *t21, *t22;
+    struct qnode_t *u0, *u1, *u2, *u3, *res;
+    const int full = (b == n->level - 2);
+    struct step_memo_t *m = NULL;
+    uint64_t slot = 0;
+
+    if (full && n->result != NULL)
+        return n->result;
+    if (n->level == 2)
+        return step_level2(u, n);
+    if (!full) {
+        slot = (qnode_hash(n->nw, n->ne, n->sw, n->se) ^ (uint64_t) (b * 0x9e37u))
+               & ((1u << STEP_HASH_BITS) - 1);
+        for (m = u->step_table[slot]; m != NULL; m = m->hash_next) {
+            if (m->node == n && m->b == b)
+                return m->result;
+        }
+    }
+
+    t00 = n->nw;
+    t01 = horizontal_node(u, n->nw, n->ne);
+    t02 = n->ne;
+    t10 = vertical_node(u, n->nw, n->sw);
+    t11 = center_node(u, n);
+    t12 = vertical_node(u, n->ne, n->se);
+    t20 = n->sw;
+    t21 = horizontal_node(u, n->sw, n->se);
+    t22 = n->se;
+
+    if (full) {
+        /* both layers advance a half step: 2^(level-3) + 2^(level-3) */
+        t00 = advance(u, t00, b - 1);
+        t01 = advance(u, t01, b - 1);
+        t02 = advance(u, t02, b - 1);
+        t10 = advance(u, t10, b - 1);
+        t11 = advance(u, t11, b - 1);
+        t12 = advance(u, t12, b - 1);
+        t20 = advance(u, t20, b - 1);
+        t21 = advance(u, t21, b - 1);
+        t22 = advance(u, t22, b - 1);
+        u0 = find_node(u, t00, t01, t10, t11);
+        u1 = find_node(u, t01, t02, t11, t12);
+        u2 = find_node(u, t10, t11, t20, t21);
+        u3 = find_node(u, t11, t12, t21, t22);
+        res = find_node(u, advance(u, u0, b - 1), advance(u, u1, b - 1),
+                        advance(u, u2, b - 1), advance(u, u3, b - 1));
+        n->result = res;
+        return res;
+    }
+
+    /* the whole 2^b advance happens in the first layer; the second layer
+       only reassembles centers */
+    t00 = advance(u, t00, b);
+    t01 = advance(u, t01, b);
+    t02 = advance(u, t02, b);
+    t10 = advance(u, t10, b);
+    t11 = advance(u, t11, b);
+    t12 = advance(u, t12, b);
+    t20 = advance(u, t20, b);
+    t21 = advance(u, t21, b);
+    t22 = advance(u, t22, b);
+    u0 = find_node(u, t00, t01, t10, t11);
+    u1 = find_node(u, t01, t02, t11, t12);
+    u2 = find_node(u, t10, t11, t20, t21);
+    u3 = find_node(u, t11, t12, t21, t22);
+    res = find_node(u, center_node(u, u0), center_node(u, u1),
+                    center_node(u, u2), center_node(u, u3));
+
+    m = xmalloc(sizeof(struct step_memo_t));
+    m->node = n;
+    m->b = b;
+    m->result = res;
+    m->hash_next = u->step_table[slot];
+    u->step_table[slot] = m;
+    return res;
+}
+
+/*****************************************************************************
+ * Building from and extracting to the flat board
+ ****************************************************************************/
+
+/**
+ * Build the level-l node whose window starts at plane row x, column y.
+ * The plane is the board tiled periodically, so the node is determined by
+ * (l, x mod nrows, y mod ncols) -- which is also the build-memo key.
+ */
+static struct qnode_t *
+build_node(struct universe_t *u, int l, int x, int y) {
+    struct build_memo_t *slot = NULL;
+    struct qnode_t *n;
+    int half;
+
+    x %= u->nrows;
+    if (x < 0) x += u->nrows;
+    y %= u->ncols;
+    if (y < 0) y += u->ncols;
+
+    if (l == 0) {
+        return u->board[x + (size_t) u->nrows * y] ? u->alive_leaf : u->dead_leaf;
+    }
+
+    slot = &u->build_memo[(((uint64_t) l * 0x9e3779b9u + (uint64_t) x * 0x85ebca6bu
+                            + (uint64_t) y * 0xc2b2ae35u)
+                           % (uint64_t) u->build_memo_size)];
+    if (slot->version == u->build_version && slot->level == l
+        && slot->x == x && slot->y == y)
+        return slot->node;
+
+    half = 1 << (l - 1);
+    n = find_node(u,
+                  build_node(u, l - 1, x, y),
+                  build_node(u, l - 1, x, y + half),
+                  build_node(u, l - 1, x + half, y),
+                  build_node(u, l - 1, x + half, y + half));
+
+    slot->version = u->build_version;
+    slot->level = l;
+    slot->x = x;
+    slot->y = y;
+    slot->node = n;
+    return n;
+}
+
+/**
+ * Write a node's live cells into the board; the window starts at board
+ * row x, column y, and anything outside the board is discarded.  The
+ * board must be zeroed beforehand; canonical empty subtrees are pruned.
+ */
+static void
+fill_board(struct universe_t *u, const struct qnode_t *n, char *board, int x, int y) {
+    int half;
+
+    if (x >= u->nrows || y >= u->ncols)
+        return;
+    if (n->level <= u->max_level && n == u->empties[n->level])
+        return;
+    if (n->level == 0) {
+        board[x + (size_t) u->nrows * y] = 1;
+        return;
+    }
+    half = 1 << (n->level - 1);
+    fill_board(u, n->nw, board, x, y);
+    fill_board(u, n->ne, board, x, y + half);
+    fill_board(u, n->sw, board, x + half, y);
+    fill_board(u, n->se, board, x + half, y + half);
+}
+
+/*****************************************************************************
+ * Universe lifetime
+ ****************************************************************************/
+
+static void
+universe_init(struct universe_t *u, const char *board, int nrows, int ncols,
+              int max_level) {
+    int l;
+
+    memset(u, 0, sizeof(*u));
+    u->table = xmalloc((1u << QNODE_HASH_BITS) * sizeof(struct qnode_t *));
+    memset(u->table, 0, (1u << QNODE_HASH_BITS) * sizeof(struct qnode_t *));
+    u->step_table = xmalloc((1u << STEP_HASH_BITS) * sizeof(struct step_memo_t *));
+    memset(u->step_table, 0, (1u << STEP_HASH_BITS) * sizeof(struct step_memo_t *));
+    u->board = board;
+    u->nrows = nrows;
+    u->ncols = ncols;
+    u->max_level = max_level;
+
+    u->dead_leaf = qnode_alloc(u);
+    memset(u->dead_leaf, 0, sizeof(struct qnode_t));
+    u->alive_leaf = qnode_alloc(u);
+    memset(u->alive_leaf, 0, sizeof(struct qnode_t));
+
+    u->empties = xmalloc((max_level + 1) * sizeof(struct qnode_t *));
+    u->empties[0] = u->dead_leaf;
+    for (l = 1; l <= max_level; l++) {
+        u->empties[l] = find_node(u, u->empties[l - 1], u->empties[l - 1],
+                                  u->empties[l - 1], u->empties[l - 1]);
+    }
+
+    u->build_memo_size = 4 * nrows * ncols / 3 + 64;
+    u->build_memo = xmalloc((size_t) u->build_memo_size * sizeof(struct build_memo_t));
+    memset(u->build_memo, 0, (size_t) u->build_memo_size * sizeof(struct build_memo_t));
+    u->build_version = 0;
+}
+
+static void
+universe_destroy(struct universe_t *u) {
+    for (int s = 0; s < (1 << STEP_HASH_BITS); s++) {
+        struct step_memo_t *m = u->step_table[s];
+        while (m != NULL) {
+            struct step_memo_t *dead = m;
+            m = m->hash_next;
+            free(dead);
+        }
+    }
+    for (int c = 0; c < u->nchunks; c++)
+        free(u->chunks[c]);
+    free(u->chunks);
+    free(u->table);
+    free(u->step_table);
+    free(u->empties);
+    free(u->build_memo);
+}
+
+/*****************************************************************************
+ * Driver
+ ****************************************************************************/
+
+/**
+ * Hashlife version of GOL.  Evolves in power-of-two jumps, rebuilding the
+ * quadtree from the flat board between jumps; the canonical node table and
+ * result caches persist across jumps, so repetitive spacetime is paid for
+ * once.  Works in place on inboard and returns it.
+ */
+char *
+hashlife_game_of_life(char *outboard,
+                      char *inboard,
+                      const int nrows,
+                      const int ncols,
+                      const int gens_max) {
+    struct universe_t u;
+    int max_level = 2;
+    int remaining = gens_max;
+    const int quarter_shift_max = 30; /* jumps are ints */
+
+    (void) outboard;
+    while ((1 << max_level) < nrows || (1 << max_level) < ncols)
+        max_level++;
+    /* two extra levels: the advanced center of the root must still cover
+       the whole board window */
+    max_level += 2;
+
+    universe_init(&u, inboard, nrows, ncols, max_level);
+
+    while (remaining > 0) {
+        struct qnode_t *root, *adv;
+        int b = 0;
+        while ((b + 1) <= max_level - 2 && (b + 1) <= quarter_shift_max
+               && (1 << (b + 1)) <= remaining)
+            b++;
+
+        u.build_version++;
+        root = build_node(&u, max_level, -(1 << (max_level - 2)),
+                          -(1 << (max_level - 2)));
+        adv = advance(&u, root, b);
+
+        memset(inboard, 0, (size_t) nrows * ncols * sizeof(char));
+        fill_board(&u, adv, inboard, 0, 0);
+        remaining -= 1 << b;
+
+        if (u.nnodes > QNODE_MAX_NODES && remaining > 0) {
+            /* the memo tables outgrew their budget; scrap the universe
+               and start over from the flat board */
+            universe_destroy(&u);
+            universe_init(&u, inboard, nrows, ncols, max_level);
+        }
+    }
+
+    universe_destroy(&u);
+    return inboard;
+}
@@ -0,0 +1,248 @@
+/*****************************************************************************
+ * life_pool.c
+ * Persistent worker pool for the encoded row-slice engine.  Callers that
+ * evolve many boards per process create the pool once; the workers stay
+ * parked on a condition variable between jobs, so each gol_evolve() call
+ * costs a wakeup instead of thread creation, pinning and teardown.
+ ****************************************************************************/
+#include "life.h"
+#include "util.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+struct gol_pool_t {
+    pthread_t *threads;
+    struct pool_worker_argument_t *worker_args;
+    /* per-job engine arguments, reusing the row-slice worker as is */
+    struct thread_argument_t *args;
+    struct arena_t arena;      /* halo rows + change lists */
+    int arena_ready;
+    int cur_nrows, cur_ncols;  /* geometry the arena was carved for */
+    int nthreads;
+    struct gol_barrier_t barrier; /* among the threads the current job uses */
+    pthread_mutex_t lock;
+    pthread_cond_t work_cv;    /* a new job was published */
+    pthread_cond_t done_cv;    /* the last participant finished */
+    volatile int changed_flags[2]; /* early-stop consensus, by parity */
+    int job_seq;
+    int job_nthreads;          /* small boards may not use every worker */
+    int done_count;
+    int shutdown;
+};
+
+struct pool_worker_argument_t {
+    struct gol_pool_t *pool;
+    int ith;
+};
+
+static void *
+pool_worker(void *args) {
+    struct pool_worker_argument_t *arg = (struct pool_worker_argument_t *) args;
+    struct gol_pool_t *pool = arg->pool;
+    int seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->job_seq == seen && !pool->shutdown) {
+            pthread_cond_wait(&pool->work_cv, &pool->lock);
+        }
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->job_seq;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (arg->ith < pool->job_nthreads) {
+            worker_fuction_by_rows_encoding(&pool->args[arg->ith]);
+            pthread_mutex_lock(&pool->lock);
+            if (++pool->done_count == pool->job_nthreads) {
+                pthread_cond_signal(&pool->done_cv);
+            }
+            pthread_mutex_unlock(&pool->lock);
+        }
+    }
+}
+
+struct gol_pool_t *
+gol_pool_create(int nthreads) {
+    struct gol_pool_t *pool;
+    int i;
+
+    if (nthreads < 1)
+        nthreads = gol_num_threads();
+    pool = malloc(sizeof(struct gol_pool_t));
+    if (pool == NULL) {
+        fprintf(stderr, "*** Failed to allocate thread pool ***\n");
+        exit(EXIT_FAILURE);
+    }
+    pool->nthreads = nthreads;
+    pool->threads = malloc(nthreads * sizeof(pthread_t));
+    pool->worker_args = malloc(nthreads * sizeof(struct pool_worker_argument_t));
+    pool->args = malloc(nthreads * sizeof(struct thread_argument_t));
+    if (pool->threads == NULL || pool->worker_args == NULL || pool->args == NULL) {
+        fprintf(stderr, "*** Failed to allocate thread pool ***\n");
+        exit(EXIT_FAILURE);
+    }
+    pool->arena_ready = 0;
+    pool->cur_nrows = 0;
+    pool->cur_ncols = 0;
+    pool->job_seq = 0;
+    pool->job_nthreads = 0;
+    pool->done_count = 0;
+    pool->shutdown = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cv, NULL);
+    pthread_cond_init(&pool->done_cv, NULL);
+
+    for (i = 0; i < nthreads; i++) {
+        pool->worker_args[i].pool = pool;
+        pool->worker_args[i].ith = i;
+        pthread_create(&pool->threads[i], NULL, pool_worker, &pool->worker_args[i]);
+        gol_pin_thread(pool->threads[i], i);
+    }
+    return pool;
+}
+
+char *
+gol_evolve(struct gol_pool_t *pool, char *outboard, char *inboard,
+           const int nrows, const int ncols, const int gens_max) {
+    /* Same clamp as the one-shot engine: each slice needs at least four
+       rows for the boundary handling to stay cheap */
+    int nthreads = pool->nthreads;
+    int max_changes, i;
+    size_t halo_bytes, change_bytes;
+    long ncpus;
+    int spin;
+    int early_stop;
+
+    if (nthreads > nrows / 4)
+        nthreads = nrows / 4;
+    if (nthreads < 1)
+        nthreads = 1;
+    max_changes = ((nrows + nthreads - 1) / nthreads + CACHE_LINE) * ncols / 4;
+    halo_bytes = 2 * (size_t) ncols * sizeof(signed char);
+    change_bytes = 2 * (size_t) max_changes * sizeof(int);
+
+    /* The arena persists across calls; recarve only when the geometry
+       changes.  (The workers refault their carves each job anyway, as
+       part of their first-touch prologue.) */
+    if (!pool->arena_ready || pool->cur_nrows != nrows || pool->cur_ncols != ncols) {
+        if (pool->arena_ready)
+            arena_destroy(&pool->arena);
+        if (arena_init(&pool->arena, (size_t) nthreads *
+                       (cache_round(halo_bytes) + cache_round(change_bytes))) != 0) {
+            fprintf(stderr, "*** Failed to allocate per-thread buffers ***\n");
+            exit(EXIT_FAILURE);
+        }
+        for (i = 0; i < nthreads; i++) {
+            pool->args[i].halo_north = arena_alloc(&pool->arena, halo_bytes);
+            pool->args[i].halo_south = pool->args[i].halo_north + ncols;
+            pool->args[i].changes = arena_alloc(&pool->arena, change_bytes);
+        }
+        pool->arena_ready = 1;
+        pool->cur_nrows = nrows;
+        pool->cur_ncols = ncols;
+    }
+
+    LDA = nrows;
+    /* Encode in place; the workers copy their slices to outboard in
+       their prologue, exactly as in parallel_game_of_life() */
+    encode_board(inboard, nrows, ncols);
+
+    /* Futex wakeups dominate tiny slices: spin at the barriers when each
+       thread's per-generation work is small and the cores are not
+       oversubscribed.  GOL_SPIN_BARRIER=0/1 overrides the heuristic. */
+    ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    spin = ((long) nrows * ncols / nthreads < (1 << 16)) &&
+           (ncpus <= 0 || nthreads <= ncpus);
+    if (getenv("GOL_SPIN_BARRIER") != NULL)
+        spin = atoi(getenv("GOL_SPIN_BARRIER")) != 0;
+    gol_barrier_init(&pool->barrier, nthreads, spin);
+    /* Opt-in early termination: stop as soon as a generation toggles no
+       cell anywhere (still life or extinct board; extinction costs one
+       extra generation, the one where the last cells die). */
+    early_stop = getenv("GOL_EARLY_STOP") != NULL &&
+                 atoi(getenv("GOL_EARLY_STOP")) != 0;
+    pool->changed_flags[0] = 0;
+    pool->changed_flags[1] = 0;
+    for (i = 0; i < nthreads; i++) {
+        pool->args[i].outboard = outboard;
+        pool->args[i].inboard = inboard;
+        pool->args[i].nrows = nrows;
+        pool->args[i].ncols = ncols;
+        pool->args[i].ith_slice = i;
+        pool->args[i].nthreads = nthreads;
+        pool->args[i].gens_max = gens_max;
+        pool->args[i].barrier = &pool->barrier;
+        pool->args[i].max_changes = max_changes;
+        pool->args[i].changed_flags = pool->changed_flags;
+        pool->args[i].early_stop = early_stop;
+    }
+    for (i = 0; i < nthreads; i++) {
+        pool->args[i].neighbor_halo_south =
+                pool->args[(i + nthreads - 1) % nthreads].halo_south;
+        pool->args[i].neighbor_halo_north =
+                pool->args[(i + 1) % nthreads].halo_north;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->job_nthreads = nthreads;
+    pool->done_count = 0;
+    pool->job_seq++;
+    pthread_cond_broadcast(&pool->work_cv);
+    while (pool->done_count < pool->job_nthreads) {
+        pthread_cond_wait(&pool->done_cv, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    gol_barrier_destroy(&pool->barrier);
+
+    gol_trace_hash = 0;
+    for (i = 0; i < nthreads; i++)
+        gol_trace_hash ^= pool->args[i].toggle_hash;
+    gol_gens_run = pool->args[0].gens_done;
+
+#ifdef GOL_STATS
+    /* one CSV row per worker; stderr so it never mixes with board output */
+    fprintf(stderr, "gol_stats: thread,gens,cells_examined,cells_changed,"
+            "copy_fallbacks,barrier_wait_ms\n");
+    for (i = 0; i < nthreads; i++) {
+        fprintf(stderr, "gol_stats: %d,%d,%lld,%lld,%lld,%.3f\n",
+                i, gens_max,
+                pool->args[i].stats.cells_examined,
+                pool->args[i].stats.cells_changed,
+                pool->args[i].stats.copy_fallbacks,
+                pool->args[i].stats.barrier_wait_ns / 1.0e6);
+    }
+#endif
+
+    // reverse the board to original encoding
+    postprocessing_board(outboard, nrows, ncols);
+    return outboard;
+}
+
+void
+gol_pool_destroy(struct gol_pool_t *pool) {
+    int i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_cv);
+    pthread_mutex_unlock(&pool->lock);
+    for (i = 0; i < pool->nthreads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_cv);
+    pthread_cond_destroy(&pool->done_cv);
+    if (pool->arena_ready)
+        arena_destroy(&pool->arena);
+    free(pool->threads);
+    free(pool->worker_args);
+    free(pool->args);
+    free(pool);
+}
@@ -0,0 +1,200 @@
+/*****************************************************************************
+ * life_sparse.c
+ * Sparse implementation of the game of life for low-density boards.  Only
+ * the cells that might change state -- last generation's toggles and their
+ * neighbours -- are visited, so a 0.1% board costs a fraction of a full
+ * O(nrows*ncols) sweep per generation.
+ ****************************************************************************/
+#include "life.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The engine reuses the count-plus-alive-bit cell encoding from life.c on a
+ * single working board.  Per generation:
+ *   1. scan the candidate list, collecting the cells that toggle;
+ *   2. apply the toggles and their neighbour-count deltas;
+ *   3. the toggled cells and their neighbours form the next candidate list.
+ * A flag board keeps the candidate list duplicate-free, so it is bounded by
+ * the board size; if it nevertheless outgrows its cap the board is no
+ * longer sparse and the remaining generations are handed to the tile
+ * engine.
+ */
+
+struct sparse_state_t {
+    char *board;     /* encoded working board */
+    char *flags;     /* nonzero iff the cell is in the candidate list */
+    int *cand;       /* current candidate cell indices */
+    int *next;       /* next generation's candidates */
+    int ncand;
+    int cap;
+    int nrows;
+    int ncols;
+};
+
+/**
+ * Add a cell to the next candidate list; returns 0 if the list is full,
+ * which signals the caller to fall back to a dense engine.
+ */
+static int sparse_add(struct sparse_state_t *st, int nnext_in, int idx, int *nnext_out) {
+    if (st->flags[idx]) {
+        *nnext_out = nnext_in;
+        return 1;
+    }
+    if (nnext_in >= st->cap)
+        return 0;
+    st->flags[idx] = 1;
+    st->next[nnext_in] = idx;
+    *nnext_out = nnext_in + 1;
+    return 1;
+}
+
+/**
+ * Apply one toggle to the working board and enroll the cell and its eight
+ * neighbours as candidates.  The board update always completes so the
+ * generation stays consistent; only the enrollment can fail, returning 0
+ * on candidate overflow.
+ */
+static int sparse_apply(struct sparse_state_t *st, int idx, int *nnext) {
+    char *board = st->board;
+    const int nrows = st->nrows;
+    const int ncols = st->ncols;
+    const int i = idx % nrows;
+    const int j = idx / nrows;
+    const int inorth = (i == 0) ? nrows - 1 : i - 1;
+    const int isouth = (i == nrows - 1) ? 0 : i + 1;
+    const int jwest = (j == 0) ? ncols - 1 : j - 1;
+    const int jeast = (j == ncols - 1) ? 0 : j + 1;
+    signed char delta;
+    int neighbors[8];
+    int k;
+
+    if (ALIVE(board[idx])) {
+        KILL(board[idx]);
+        delta = -1;
+    }
+    else {
+        SPAWN(board[idx]);
+        delta = 1;
+    }
+
+    neighbors[0] = inorth + LDA * jwest;
+    neighbors[1] = inorth + LDA * j;
+    neighbors[2] = inorth + LDA * jeast;
+    neighbors[3] = i + LDA * jwest;
+    neighbors[4] = i + LDA * jeast;
+    neighbors[5] = isouth + LDA * jwest;
+    neighbors[6] = isouth + LDA * j;
+    neighbors[7] = isouth + LDA * jeast;
+
+    for (k = 0; k < 8; k++) {
+        board[neighbors[k]] += delta;
+    }
+
+    if (!sparse_add(st, *nnext, idx, nnext))
+        return 0;
+    for (k = 0; k < 8; k++) {
+        if (!sparse_add(st, *nnext, neighbors[k], nnext))
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * Sparse version of GOL, selected by game_of_life() when the measured
+ * live-cell density is low.  Sequential: at the densities it is picked
+ * for, the candidate walk is far below the cost of a single dense sweep,
+ * and parallel overheads would dominate.
+ */
+char *
+sparse_game_of_life(char *outboard,
+                    char *inboard,
+                    const int nrows,
+                    const int ncols,
+                    const int gens_max) {
+    struct sparse_state_t st;
+    const int total = nrows * ncols;
+    int curgen, k, overflow = 0;
+
+    st.nrows = nrows;
+    st.ncols = ncols;
+    st.cap = total / 8 + 16;
+    st.flags = calloc(total, sizeof(char));
+    st.cand = malloc((size_t) st.cap * sizeof(int));
+    st.next = malloc((size_t) st.cap * sizeof(int));
+    if (st.flags == NULL || st.cand == NULL || st.next == NULL) {
+        fprintf(stderr, "*** Failed to allocate sparse engine state ***\n");
+        exit(EXIT_FAILURE);
+    }
+
+    LDA = nrows;
+    /* encode the board; afterwards inboard and outboard are identical and
+       we only ever touch outboard */
+    preprocessing_board(inboard, outboard, nrows, ncols);
+    st.board = outboard;
+
+    /* initial candidates: every cell that is alive or has a live
+       neighbour, i.e. every nonzero encoded cell */
+    st.ncand = 0;
+    for (k = 0; k < total; k++) {
+        if (st.board[k] != 0) {
+            if (st.ncand >= st.cap) {
+                overflow = 1;
+                break;
+            }
+            st.flags[k] = 1;
+            st.cand[st.ncand++] = k;
+        }
+    }
+
+    for (curgen = 0; curgen < gens_max && !overflow; curgen++) {
+        int nchanged = 0;
+        int nnext = 0;
+        int *tmp;
+
+        /* pass 1: find the toggles; reuse the candidate array's consumed
+           prefix to hold them, since nchanged can never overtake k */
+        for (k = 0; k < st.ncand; k++) {
+            int idx = st.cand[k];
+            char cell = st.board[idx];
+            st.flags[idx] = 0;
+            if (ALIVE(cell) ? TOKILL(cell) : TOSPAWN(cell)) {
+                st.cand[nchanged++] = idx;
+            }
+        }
+        if (nchanged == 0) {
+            /* steady state: no cell will ever change again.  Report the
+               short run so gol.c's early-stop message covers boards that
+               dispatched here instead of to the row-slice engine. */
+            gol_gens_run = curgen;
+            break;
+        }
+        /* pass 2: apply the toggles and gather the next candidates; on
+           overflow keep applying so the generation completes before the
+           dense fallback takes over */
+        for (k = 0; k < nchanged; k++) {
+            if (!sparse_apply(&st, st.cand[k], &nnext)) {
+                overflow = 1;
+            }
+        }
+        tmp = st.cand;
+        st.cand = st.next;
+        st.next = tmp;
+        st.ncand = nnext;
+    }
+
+    free(st.flags);
+    free(st.cand);
+    free(st.next);
+
+    postprocessing_board(outboard, nrows, ncols);
+    if (overflow) {
+        /* the board stopped being sparse: hand the remaining generations
+           to the dense tile engine (inboard is free for ping-ponging) */
+        return tile_game_of_life(inboard, outboard, nrows, ncols,
+                                 gens_max - curgen);
+    }
+    return outboard;
+}
@@ -0,0 +1,153 @@
+/*****************************************************************************
+ * life_stream.c
+ * Streaming band implementation of the game of life for boards too large
+ * for the dense engines' double-buffered working sets.  The board is
+ * evolved in place, one band of columns at a time, with the columns on the
+ * band edges stashed before each generation so neighbouring bands can still
+ * read the previous generation's values.  Per-thread state is a handful of
+ * columns, so the working set stays cache-resident no matter how large the
+ * board grows.
+ ****************************************************************************/
+#include "life.h"
+#include "util.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The boards are stored column-major, so the contiguous "bands" here are
+ * runs of whole columns rather than the horizontal row bands of the
+ * literature.  Each thread owns columns [jstart, jend) and sweeps them
+ * west to east.  Column j is overwritten only after its original values
+ * have been rolled into prev_orig, and the two columns a band reads from
+ * its neighbours -- the original of its own west neighbour and the
+ * original of the next band's first column -- are stashed before a
+ * barrier, so the in-place update never sees a half-evolved column.
+ */
+
+//Arguments handed to each streaming worker thread.
+struct stream_thread_argument_t {
+    char *board;
+    char *west_orig;   /* original of column jstart-1, private */
+    char *first_orig;  /* original of column jstart, read by the west band */
+    const char *east_orig; /* the east band's first_orig */
+    int jstart;
+    int jend;
+    int nrows;
+    int ncols;
+    int gens_max;
+    pthread_barrier_t *barrier;
+};
+
+static void *
+stream_worker_function(void *args) {
+    struct stream_thread_argument_t *arg = (struct stream_thread_argument_t *) args;
+    char *board = arg->board;
+    const int nrows = arg->nrows;
+    const int ncols = arg->ncols;
+    char *prev = NULL;   /* original values of column j-1 */
+    char *next = NULL;   /* new values of column j under construction */
+    int curgen, i, j;
+
+    prev = malloc(nrows * sizeof(char));
+    next = malloc(nrows * sizeof(char));
+    if (prev == NULL || next == NULL) {
+        fprintf(stderr, "*** Failed to allocate streaming column buffers ***\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (curgen = 0; curgen < arg->gens_max; curgen++) {
+        /* stash the boundary columns while every band still holds the
+           previous generation */
+        memcpy(arg->west_orig, board + (size_t) nrows * mod(arg->jstart - 1, ncols),
+               nrows * sizeof(char));
+        memcpy(arg->first_orig, board + (size_t) nrows * arg->jstart,
+               nrows * sizeof(char));
+        pthread_barrier_wait(arg->barrier);
+
+        memcpy(prev, arg->west_orig, nrows * sizeof(char));
+        for (j = arg->jstart; j < arg->jend; j++) {
+            char *mid = board + (size_t) nrows * j;
+            /* columns east of j in this band are still original; the
+               first column of the east band comes from its stash */
+            const char *east = (j == arg->jend - 1)
+                    ? arg->east_orig
+                    : board + (size_t) nrows * (j + 1);
+            for (i = 0; i < nrows; i++) {
+                const int inorth = mod(i - 1, nrows);
+                const int isouth = mod(i + 1, nrows);
+                const char neighbor_count =
+                        prev[inorth] + prev[i] + prev[isouth] +
+                        mid[inorth] + mid[isouth] +
+                        east[inorth] + east[i] + east[isouth];
+                next[i] = alivep(neighbor_count, mid[i]);
+            }
+            memcpy(prev, mid, nrows * sizeof(char));
+            memcpy(mid, next, nrows * sizeof(char));
+        }
+        pthread_barrier_wait(arg->barrier);
+    }
+
+    free(prev);
+    free(next);
+    return NULL;
+}
+
+/**
+ * Streaming version of GOL, selected by game_of_life() for boards beyond
+ * the dense engines' size limit.  Evolves inboard in place and returns it;
+ * outboard is not touched, so callers with memory to spare can keep it.
+ */
+char *
+stream_game_of_life(char *outboard,
+                    char *inboard,
+                    const int nrows,
+                    const int ncols,
+                    const int gens_max) {
+    struct stream_thread_argument_t *args;
+    pthread_t *worker_threads;
+    pthread_barrier_t barrier;
+    char *stash;
+    int nthreads = gol_num_threads();
+    int i;
+
+    (void) outboard;
+    if (nthreads > ncols)
+        nthreads = ncols;
+    args = malloc(nthreads * sizeof(struct stream_thread_argument_t));
+    worker_threads = malloc(nthreads * sizeof(pthread_t));
+    stash = malloc(2 * (size_t) nthreads * nrows * sizeof(char));
+    if (args == NULL || worker_threads == NULL || stash == NULL) {
+        fprintf(stderr, "*** Failed to allocate per-thread buffers ***\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_barrier_init(&barrier, NULL, nthreads);
+    for (i = 0; i < nthreads; ++i) {
+        args[i].board = inboard;
+        args[i].west_orig = stash + 2 * (size_t) i * nrows;
+        args[i].first_orig = stash + (2 * (size_t) i + 1) * nrows;
+        args[i].jstart = i * ncols / nthreads;
+        args[i].jend = (i + 1) * ncols / nthreads;
+        args[i].nrows = nrows;
+        args[i].ncols = ncols;
+        args[i].gens_max = gens_max;
+        args[i].barrier = &barrier;
+    }
+    for (i = 0; i < nthreads; ++i) {
+        /* the east neighbour's stash; the last band wraps to the first */
+        args[i].east_orig = args[(i + 1) % nthreads].first_orig;
+        pthread_create(&worker_threads[i], NULL, stream_worker_function, &args[i]);
+        gol_pin_thread(worker_threads[i], i);
+    }
+    for (i = 0; i < nthreads; ++i) {
+        pthread_join(worker_threads[i], NULL);
+    }
+    pthread_barrier_destroy(&barrier);
+
+    free(args);
+    free(worker_threads);
+    free(stash);
+    return inboard;
+}
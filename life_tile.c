@@ -0,0 +1,600 @@
+/*****************************************************************************
+ * life_tile.c
+ * Tiled implementation of the encoded game of life.  The board is cut into
+ * tiles (64x64 by default) that are handed out through per-thread
+ * work-stealing deques, so threads balance with the population
+ * distribution instead of the geometry.  Neighbour-count deltas that land
+ * outside a tile are accumulated in per-tile ring buffers and folded in
+ * during a second, equally stealable merge pass.
+ ****************************************************************************/
+#include "life.h"
+#include "util.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TILE_DIM 64
+
+/*
+ * One tile of the board.  The four ring buffers hold the deltas this
+ * tile's cells aimed at the row/column just outside it:
+ *   ring_n/ring_s: rows r0-1 and r1, columns [c0-1, c1] (corners included)
+ *   ring_w/ring_e: columns c0-1 and c1, rows [r0, r1) only
+ * Each ring entry has exactly one consuming tile, which also clears it.
+ */
+struct tile_t {
+    int r0, r1; /* row range [r0, r1) */
+    int c0, c1; /* column range [c0, c1) */
+    signed char *ring_n;
+    signed char *ring_s;
+    signed char *ring_w;
+    signed char *ring_e;
+    int *changes; /* (i, j) pairs toggled this generation */
+    int nchanges;
+    int max_changes;
+    /* dirty tracking: a tile is skipped while nothing in it or entering
+       it has changed; a tile whose toggle list repeated exactly with no
+       outside deltas is period-2 and replays the list without scanning */
+    int *prev_changes; /* last generation's toggle list */
+    int nprev;
+    int dirty;        /* cells may toggle this generation */
+    int extern_dirty; /* deltas were folded in from neighbouring tiles */
+    int osc2;         /* toggle list is repeating (period-2 region) */
+};
+
+/*
+ * Work-stealing deque over a contiguous range of tile indices.  The owner
+ * pops from the head, thieves take from the tail.  The epoch stamp lets a
+ * queue be reset lazily at the start of each phase without a dedicated
+ * barrier: a thief simply ignores queues still stamped with an old phase.
+ */
+struct ws_queue_t {
+    pthread_mutex_t lock;
+    int epoch;
+    int next;
+    int limit;
+};
+
+struct tile_engine_t {
+    char *outboard;
+    char *inboard;
+    int nrows;
+    int ncols;
+    int gens_max;
+    int ntr, ntc;     /* tile grid dimensions */
+    int nthreads;
+    struct tile_t *tiles;
+    struct ws_queue_t *queues;
+    pthread_barrier_t barrier;
+};
+
+struct tile_thread_argument_t {
+    struct tile_engine_t *eng;
+    int ith;
+};
+
+/*****************************************************************************
+ * Work-stealing deque
+ ****************************************************************************/
+
+static void ws_reset(struct ws_queue_t *q, int epoch, int lo, int hi) {
+    pthread_mutex_lock(&q->lock);
+    q->epoch = epoch;
+    q->next = lo;
+    q->limit = hi;
+    pthread_mutex_unlock(&q->lock);
+}
+
+static int ws_pop_own(struct ws_queue_t *q, int *tile) {
+    int got = 0;
+    pthread_mutex_lock(&q->lock);
+    if (q->next < q->limit) {
+        *tile = q->next++;
+        got = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return got;
+}
+
+/* Scan the other queues once and steal one tile from the first victim
+   that has work in the current phase.  Returns 0 when nothing is left
+   to steal; the victim will then finish its own range by itself. */
+static int ws_steal(struct tile_engine_t *eng, int self, int epoch, int *tile) {
+    for (int k = 1; k < eng->nthreads; k++) {
+        struct ws_queue_t *q = &eng->queues[(self + k) % eng->nthreads];
+        int got = 0;
+        pthread_mutex_lock(&q->lock);
+        if (q->epoch == epoch && q->next < q->limit) {
+            *tile = --q->limit;
+            got = 1;
+        }
+        pthread_mutex_unlock(&q->lock);
+        if (got)
+            return 1;
+    }
+    return 0;
+}
+
+/*****************************************************************************
+ * Compute phase
+ ****************************************************************************/
+
+/**
+ * Update one cell on a tile edge.  Deltas whose target falls outside the
+ * tile are routed to the rings by source position (first/last row or
+ * column of the tile), which the merge pass undoes symmetrically -- this
+ * also covers toroidal wraparound, since the consuming tile is looked up
+ * modulo the tile grid.  Returns nonzero if the cell toggled.
+ */
+static int do_cell_tile_edge(struct tile_t *t, char *outboard, char *inboard,
+                             int i, int j) {
+    char cell = BOARD(inboard, i, j);
+    signed char delta;
+    /* ring_n/ring_s slots for jwest, j, jeast: the rings start at column
+       c0-1, so the slot for column j-1 is j-c0 and so on */
+    const int wjw = j - t->c0;
+    const int wj = j - t->c0 + 1;
+    const int wje = j - t->c0 + 2;
+    const int in_w = (j > t->c0);     /* jwest falls inside the tile */
+    const int in_e = (j < t->c1 - 1); /* jeast falls inside the tile */
+
+    if (ALIVE(cell)) {
+        if (!TOKILL(cell)) return 0;
+        KILL(BOARD(outboard, i, j));
+        delta = -1;
+    }
+    else {
+        if (!TOSPAWN(cell)) return 0;
+        SPAWN(BOARD(outboard, i, j));
+        delta = 1;
+    }
+
+    /* north row */
+    if (i == t->r0) {
+        t->ring_n[wjw] += delta;
+        t->ring_n[wj] += delta;
+        t->ring_n[wje] += delta;
+    }
+    else {
+        if (in_w) BOARD(outboard, i - 1, j - 1) += delta;
+        else t->ring_w[i - 1 - t->r0] += delta;
+        BOARD(outboard, i - 1, j) += delta;
+        if (in_e) BOARD(outboard, i - 1, j + 1) += delta;
+        else t->ring_e[i - 1 - t->r0] += delta;
+    }
+    /* middle row */
+    if (in_w) BOARD(outboard, i, j - 1) += delta;
+    else t->ring_w[i - t->r0] += delta;
+    if (in_e) BOARD(outboard, i, j + 1) += delta;
+    else t->ring_e[i - t->r0] += delta;
+    /* south row */
+    if (i == t->r1 - 1) {
+        t->ring_s[wjw] += delta;
+        t->ring_s[wj] += delta;
+        t->ring_s[wje] += delta;
+    }
+    else {
+        if (in_w) BOARD(outboard, i + 1, j - 1) += delta;
+        else t->ring_w[i + 1 - t->r0] += delta;
+        BOARD(outboard, i + 1, j) += delta;
+        if (in_e) BOARD(outboard, i + 1, j + 1) += delta;
+        else t->ring_e[i + 1 - t->r0] += delta;
+    }
+    return 1;
+}
+
+/**
+ * Reapply a cached toggle list to the output board: the period-2 fast
+ * path, which skips the cell scan entirely.  The listed cells genuinely
+ * toggle, so the edge helper's own state test is guaranteed to fire.
+ */
+static void apply_cached_changes(struct tile_engine_t *eng, struct tile_t *t) {
+    char *outboard = eng->outboard;
+    char *inboard = eng->inboard;
+    int k;
+
+    memcpy(t->changes, t->prev_changes, 2 * (size_t) t->nprev * sizeof(int));
+    t->nchanges = t->nprev;
+    for (k = 0; k < t->nchanges; k++) {
+        const int i = t->changes[2 * k];
+        const int j = t->changes[2 * k + 1];
+        if (i == t->r0 || i == t->r1 - 1 || j == t->c0 || j == t->c1 - 1) {
+            do_cell_tile_edge(t, outboard, inboard, i, j);
+        }
+        else {
+            char cell = BOARD(inboard, i, j);
+            signed char delta;
+            if (ALIVE(cell)) {
+                KILL(BOARD(outboard, i, j));
+                delta = -1;
+            }
+            else {
+                SPAWN(BOARD(outboard, i, j));
+                delta = 1;
+            }
+            BOARD(outboard, i - 1, j - 1) += delta;
+            BOARD(outboard, i - 1, j) += delta;
+            BOARD(outboard, i - 1, j + 1) += delta;
+            BOARD(outboard, i, j - 1) += delta;
+            BOARD(outboard, i, j + 1) += delta;
+            BOARD(outboard, i + 1, j - 1) += delta;
+            BOARD(outboard, i + 1, j) += delta;
+            BOARD(outboard, i + 1, j + 1) += delta;
+        }
+    }
+}
+
+static void compute_tile(struct tile_engine_t *eng, struct tile_t *t) {
+    char *outboard = eng->outboard;
+    char *inboard = eng->inboard;
+    int *changes = t->changes;
+    int nchanges = t->nchanges;
+    const int max_changes = t->max_changes;
+    int i, j;
+
+    if (!t->dirty) {
+        /* nothing in or entering this tile changed last generation, so
+           nothing in it can toggle now */
+        return;
+    }
+    if (t->osc2 && !t->extern_dirty) {
+        apply_cached_changes(eng, t);
+        return;
+    }
+
+    for (j = t->c0; j < t->c1; j++) {
+        if (j == t->c0 || j == t->c1 - 1) {
+            /* whole column is tile edge */
+            for (i = t->r0; i < t->r1; i++) {
+                if (do_cell_tile_edge(t, outboard, inboard, i, j)
+                    && nchanges < max_changes) {
+                    changes[2 * nchanges] = i;
+                    changes[2 * nchanges + 1] = j;
+                    nchanges++;
+                }
+            }
+        }
+        else {
+            const char *im = &BOARD(inboard, 0, j);
+            char *ow = &BOARD(outboard, 0, j - 1);
+            char *om = &BOARD(outboard, 0, j);
+            char *oe = &BOARD(outboard, 0, j + 1);
+
+            if (do_cell_tile_edge(t, outboard, inboard, t->r0, j)
+                && nchanges < max_changes) {
+                changes[2 * nchanges] = t->r0;
+                changes[2 * nchanges + 1] = j;
+                nchanges++;
+            }
+            /* interior: all eight targets are in-tile and unwrapped, so
+               the update is pure pointer arithmetic (see life.c) */
+            for (i = t->r0 + 1; i < t->r1 - 1; i++) {
+                char cell = im[i];
+                if (ALIVE(cell) ? TOKILL(cell) : TOSPAWN(cell)) {
+                    signed char delta;
+                    if (ALIVE(cell)) {
+                        KILL(om[i]);
+                        delta = -1;
+                    }
+                    else {
+                        SPAWN(om[i]);
+                        delta = 1;
+                    }
+                    ow[i - 1] += delta;
+                    ow[i] += delta;
+                    ow[i + 1] += delta;
+                    om[i - 1] += delta;
+                    om[i + 1] += delta;
+                    oe[i - 1] += delta;
+                    oe[i] += delta;
+                    oe[i + 1] += delta;
+                    if (nchanges < max_changes) {
+                        changes[2 * nchanges] = i;
+                        changes[2 * nchanges + 1] = j;
+                        nchanges++;
+                    }
+                }
+            }
+            if (t->r1 - 1 > t->r0
+                && do_cell_tile_edge(t, outboard, inboard, t->r1 - 1, j)
+                && nchanges < max_changes) {
+                changes[2 * nchanges] = t->r1 - 1;
+                changes[2 * nchanges + 1] = j;
+                nchanges++;
+            }
+        }
+    }
+    t->nchanges = nchanges;
+    /* An unchanged toggle list with no outside deltas means the tile's
+       state two generations ago has been restored exactly: the region is
+       period-2 and the list can be replayed blindly from here on. */
+    t->osc2 = (nchanges > 0 && nchanges < max_changes && !t->extern_dirty
+               && nchanges == t->nprev
+               && memcmp(changes, t->prev_changes,
+                         2 * (size_t) nchanges * sizeof(int)) == 0);
+}
+
+/*****************************************************************************
+ * Merge phase
+ ****************************************************************************/
+
+/**
+ * Replay one recorded toggle on the input board, restricted to the cells
+ * of the owning tile; deltas that left the tile were routed through the
+ * rings and are folded into the input board by the merge pass.
+ */
+static void replay_cell_tile(char *inboard, const struct tile_t *t, int i, int j) {
+    signed char delta;
+    const int in_n = (i > t->r0);
+    const int in_s = (i < t->r1 - 1);
+    const int in_w = (j > t->c0);
+    const int in_e = (j < t->c1 - 1);
+
+    if (ALIVE(BOARD(inboard, i, j))) {
+        KILL(BOARD(inboard, i, j));
+        delta = -1;
+    }
+    else {
+        SPAWN(BOARD(inboard, i, j));
+        delta = 1;
+    }
+
+    if (in_n) {
+        if (in_w) BOARD(inboard, i - 1, j - 1) += delta;
+        BOARD(inboard, i - 1, j) += delta;
+        if (in_e) BOARD(inboard, i - 1, j + 1) += delta;
+    }
+    if (in_w) BOARD(inboard, i, j - 1) += delta;
+    if (in_e) BOARD(inboard, i, j + 1) += delta;
+    if (in_s) {
+        if (in_w) BOARD(inboard, i + 1, j - 1) += delta;
+        BOARD(inboard, i + 1, j) += delta;
+        if (in_e) BOARD(inboard, i + 1, j + 1) += delta;
+    }
+}
+
+static struct tile_t *grid_tile(struct tile_engine_t *eng, int tr, int tc) {
+    tr = (tr + eng->ntr) % eng->ntr;
+    tc = (tc + eng->ntc) % eng->ntc;
+    return &eng->tiles[tr * eng->ntc + tc];
+}
+
+/**
+ * Fold every ring entry aimed at this tile into the output board (and the
+ * input board, unless the tile falls back to a bulk copy), then bring the
+ * input board up to date.  Entries are cleared as they are consumed.
+ */
+static void merge_tile(struct tile_engine_t *eng, int tr, int tc) {
+    struct tile_t *t = grid_tile(eng, tr, tc);
+    struct tile_t *up = grid_tile(eng, tr - 1, tc);
+    struct tile_t *down = grid_tile(eng, tr + 1, tc);
+    struct tile_t *left = grid_tile(eng, tr, tc - 1);
+    struct tile_t *right = grid_tile(eng, tr, tc + 1);
+    struct tile_t *upleft = grid_tile(eng, tr - 1, tc - 1);
+    struct tile_t *upright = grid_tile(eng, tr - 1, tc + 1);
+    struct tile_t *downleft = grid_tile(eng, tr + 1, tc - 1);
+    struct tile_t *downright = grid_tile(eng, tr + 1, tc + 1);
+    char *outboard = eng->outboard;
+    char *inboard = eng->inboard;
+    /* at this churn rate copying the tile beats replaying it */
+    const int bulk = (t->nchanges >= t->max_changes);
+    const int tw = t->c1 - t->c0;
+    const int th = t->r1 - t->r0;
+    signed char d;
+    int w, h, folded_any = 0;
+    int *tmp;
+
+#define FOLD(__i, __j, __d) do { \
+    if (__d) { \
+        BOARD(outboard, __i, __j) += (__d); \
+        if (!bulk) BOARD(inboard, __i, __j) += (__d); \
+        folded_any = 1; \
+    } \
+} while (0)
+
+    /* first row: from the south rings of the tiles above */
+    for (w = 0; w < tw; w++) {
+        d = up->ring_s[w + 1];
+        up->ring_s[w + 1] = 0;
+        FOLD(t->r0, t->c0 + w, d);
+    }
+    d = upleft->ring_s[upleft->c1 - upleft->c0 + 1];
+    upleft->ring_s[upleft->c1 - upleft->c0 + 1] = 0;
+    FOLD(t->r0, t->c0, d);
+    d = upright->ring_s[0];
+    upright->ring_s[0] = 0;
+    FOLD(t->r0, t->c1 - 1, d);
+
+    /* last row: from the north rings of the tiles below */
+    for (w = 0; w < tw; w++) {
+        d = down->ring_n[w + 1];
+        down->ring_n[w + 1] = 0;
+        FOLD(t->r1 - 1, t->c0 + w, d);
+    }
+    d = downleft->ring_n[downleft->c1 - downleft->c0 + 1];
+    downleft->ring_n[downleft->c1 - downleft->c0 + 1] = 0;
+    FOLD(t->r1 - 1, t->c0, d);
+    d = downright->ring_n[0];
+    downright->ring_n[0] = 0;
+    FOLD(t->r1 - 1, t->c1 - 1, d);
+
+    /* first and last columns: from the side rings of the tiles beside */
+    for (h = 0; h < th; h++) {
+        d = left->ring_e[h];
+        left->ring_e[h] = 0;
+        FOLD(t->r0 + h, t->c0, d);
+        d = right->ring_w[h];
+        right->ring_w[h] = 0;
+        FOLD(t->r0 + h, t->c1 - 1, d);
+    }
+#undef FOLD
+
+    if (bulk) {
+        for (w = 0; w < tw; w++) {
+            memcpy(&BOARD(inboard, t->r0, t->c0 + w),
+                   &BOARD(outboard, t->r0, t->c0 + w), th * sizeof(char));
+        }
+    }
+    else {
+        for (w = 0; w < t->nchanges; w++) {
+            replay_cell_tile(inboard, t, t->changes[2 * w], t->changes[2 * w + 1]);
+        }
+    }
+
+    /* bookkeeping for the dirty tracking: this generation's list becomes
+       the cached one, and the tile sleeps unless something happened */
+    tmp = t->prev_changes;
+    t->prev_changes = t->changes;
+    t->changes = tmp;
+    t->nprev = bulk ? 0 : t->nchanges;
+    if (bulk)
+        t->osc2 = 0;
+    t->extern_dirty = folded_any;
+    t->dirty = folded_any || t->nchanges > 0;
+    t->nchanges = 0;
+}
+
+/*****************************************************************************
+ * Worker and driver
+ ****************************************************************************/
+
+static void *tile_worker_function(void *args) {
+    struct tile_thread_argument_t *arg = (struct tile_thread_argument_t *) args;
+    struct tile_engine_t *eng = arg->eng;
+    const int ith = arg->ith;
+    const int ntiles = eng->ntr * eng->ntc;
+    const int lo = ith * ntiles / eng->nthreads;
+    const int hi = (ith + 1) * ntiles / eng->nthreads;
+    struct ws_queue_t *own = &eng->queues[ith];
+    int tile;
+
+    for (int curgen = 0; curgen < eng->gens_max; ++curgen) {
+        ws_reset(own, 2 * curgen + 1, lo, hi);
+        while (ws_pop_own(own, &tile))
+            compute_tile(eng, &eng->tiles[tile]);
+        while (ws_steal(eng, ith, 2 * curgen + 1, &tile))
+            compute_tile(eng, &eng->tiles[tile]);
+        pthread_barrier_wait(&eng->barrier);
+
+        ws_reset(own, 2 * curgen + 2, lo, hi);
+        while (ws_pop_own(own, &tile))
+            merge_tile(eng, tile / eng->ntc, tile % eng->ntc);
+        while (ws_steal(eng, ith, 2 * curgen + 2, &tile))
+            merge_tile(eng, tile / eng->ntc, tile % eng->ntc);
+        pthread_barrier_wait(&eng->barrier);
+    }
+    return NULL;
+}
+
+/**
+ * Tiled version of GOL.  Same encoded-board scheme as
+ * parallel_game_of_life(), but decomposed into tiles that threads steal
+ * from one another, so clustered populations still spread across cores.
+ */
+char *
+tile_game_of_life(char *outboard,
+                  char *inboard,
+                  const int nrows,
+                  const int ncols,
+                  const int gens_max) {
+    struct tile_engine_t eng;
+    struct tile_thread_argument_t *targs;
+    pthread_t *worker_threads;
+    int ntiles, i;
+
+    eng.outboard = outboard;
+    eng.inboard = inboard;
+    eng.nrows = nrows;
+    eng.ncols = ncols;
+    eng.gens_max = gens_max;
+    eng.ntr = (nrows + TILE_DIM - 1) / TILE_DIM;
+    eng.ntc = (ncols + TILE_DIM - 1) / TILE_DIM;
+    ntiles = eng.ntr * eng.ntc;
+
+    eng.nthreads = gol_num_threads();
+    if (eng.nthreads > ntiles)
+        eng.nthreads = ntiles;
+
+    eng.tiles = malloc(ntiles * sizeof(struct tile_t));
+    eng.queues = malloc(eng.nthreads * sizeof(struct ws_queue_t));
+    targs = malloc(eng.nthreads * sizeof(struct tile_thread_argument_t));
+    worker_threads = malloc(eng.nthreads * sizeof(pthread_t));
+    if (eng.tiles == NULL || eng.queues == NULL
+        || targs == NULL || worker_threads == NULL) {
+        fprintf(stderr, "*** Failed to allocate tile engine state ***\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < ntiles; i++) {
+        struct tile_t *t = &eng.tiles[i];
+        int tr = i / eng.ntc, tc = i % eng.ntc;
+        int tw, th, ring_bytes;
+        signed char *rings;
+
+        t->r0 = tr * nrows / eng.ntr;
+        t->r1 = (tr + 1) * nrows / eng.ntr;
+        t->c0 = tc * ncols / eng.ntc;
+        t->c1 = (tc + 1) * ncols / eng.ntc;
+        tw = t->c1 - t->c0;
+        th = t->r1 - t->r0;
+        ring_bytes = 2 * (tw + 2) + 2 * th;
+        rings = calloc(ring_bytes, sizeof(signed char));
+        t->max_changes = tw * th / 4 + 1;
+        t->changes = malloc((size_t) t->max_changes * 2 * sizeof(int));
+        t->prev_changes = malloc((size_t) t->max_changes * 2 * sizeof(int));
+        if (rings == NULL || t->changes == NULL || t->prev_changes == NULL) {
+            fprintf(stderr, "*** Failed to allocate tile buffers ***\n");
+            exit(EXIT_FAILURE);
+        }
+        t->ring_n = rings;
+        t->ring_s = rings + (tw + 2);
+        t->ring_w = rings + 2 * (tw + 2);
+        t->ring_e = rings + 2 * (tw + 2) + th;
+        t->nchanges = 0;
+        t->nprev = 0;
+        t->dirty = 1; /* everything gets one full scan to start */
+        t->extern_dirty = 1;
+        t->osc2 = 0;
+    }
+    for (i = 0; i < eng.nthreads; i++) {
+        pthread_mutex_init(&eng.queues[i].lock, NULL);
+        eng.queues[i].epoch = 0;
+        eng.queues[i].next = 0;
+        eng.queues[i].limit = 0;
+    }
+    pthread_barrier_init(&eng.barrier, NULL, eng.nthreads);
+
+    LDA = nrows;
+    // apply encoding to the board
+    preprocessing_board(inboard, outboard, nrows, ncols);
+
+    for (i = 0; i < eng.nthreads; ++i) {
+        targs[i].eng = &eng;
+        targs[i].ith = i;
+        pthread_create(&worker_threads[i], NULL, tile_worker_function, &targs[i]);
+        gol_pin_thread(worker_threads[i], i);
+    }
+    for (i = 0; i < eng.nthreads; ++i) {
+        pthread_join(worker_threads[i], NULL);
+    }
+    pthread_barrier_destroy(&eng.barrier);
+
+    // reverse the board to original encoding
+    postprocessing_board(outboard, nrows, ncols);
+
+    for (i = 0; i < ntiles; i++) {
+        free(eng.tiles[i].ring_n); /* one block holds all four rings */
+        free(eng.tiles[i].changes);
+        free(eng.tiles[i].prev_changes);
+    }
+    for (i = 0; i < eng.nthreads; i++) {
+        pthread_mutex_destroy(&eng.queues[i].lock);
+    }
+    free(eng.tiles);
+    free(eng.queues);
+    free(targs);
+    free(worker_threads);
+
+    return outboard;
+}
@@ -1,19 +1,27 @@
 #include "load.h"
+#include "life.h"
 #include <assert.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 char*
 make_board (const int nrows, const int ncols)
 {
   char* board = NULL;
-  int i;
 
-  /* Allocate the board and fill in with 'Z' (instead of a number, so
-     that it's easy to diagnose bugs */
-  board = malloc (2 * nrows * ncols * sizeof (char));
+  /* Cache-line alignment keeps a SIMD load of column data inside whole
+     lines and lets the engines align their slice seams to line
+     boundaries.  The cells are deliberately left untouched: on NUMA
+     hosts physical pages are placed at first write, so whichever thread
+     first fills a slice (the parser threads, or a pinned worker) gets
+     it on its local node. */
+  if (posix_memalign ((void**) &board, 64, 2 * (size_t) nrows * ncols) != 0)
+    board = NULL;
   assert (board != NULL);
-  for (i = 0; i < nrows * ncols; i++)
-    board[i] = 'Z';
 
   return board;
 }
@@ -22,7 +30,7 @@ static void
 load_dimensions (FILE* input, int* nrows, int* ncols)
 {
   int ngotten = 0;
-  
+
   ngotten = fscanf (input, "P1\n%d %d\n", nrows, ncols);
   if (ngotten < 1)
     {
@@ -44,23 +52,115 @@ load_dimensions (FILE* input, int* nrows, int* ncols)
     }
 }
 
+//Arguments handed to each parser thread.
+struct parse_argument_t
+{
+  const char* text;   /* cell section of the mapped file, 2 bytes/cell */
+  char* board;
+  size_t start;
+  size_t end;
+  int ok;
+};
+
+static void*
+parse_worker (void* args)
+{
+  struct parse_argument_t* arg = (struct parse_argument_t*) args;
+  const char* text = arg->text;
+  size_t i;
+
+  arg->ok = 1;
+  for (i = arg->start; i < arg->end; i++)
+    {
+      const char c = text[2 * i];
+      if ((c != '0' && c != '1') || text[2 * i + 1] != '\n')
+	{
+	  arg->ok = 0;
+	  return NULL;
+	}
+      arg->board[i] = c - '0';
+    }
+  return NULL;
+}
+
+/**
+ * Fast path for text boards: the cell section written by save_board() is
+ * exactly two bytes per cell ("%c\n"), so the file is mapped once and the
+ * scan is split across threads at computable offsets.  Returns 0 without
+ * consuming the stream if the file does not have the fixed stride (e.g.
+ * hand-edited whitespace), so the caller can fall back to fscanf.
+ */
+static int
+load_board_values_fast (FILE* input, char* board, const size_t total)
+{
+  const int fd = fileno (input);
+  const long offset = ftell (input);
+  struct stat st;
+  const char* bytes = NULL;
+  struct parse_argument_t* args = NULL;
+  pthread_t* threads = NULL;
+  int nthreads, i, ok;
+
+  if (fd < 0 || offset < 0 || fstat (fd, &st) != 0 ||
+      st.st_size - offset < (off_t) (2 * total))
+    return 0;
+  bytes = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (bytes == MAP_FAILED)
+    return 0;
+
+  /* below ~64k cells thread startup costs more than the scan */
+  nthreads = (total < ((size_t) 1 << 16)) ? 1 : gol_num_threads ();
+  args = malloc (nthreads * sizeof (struct parse_argument_t));
+  threads = malloc (nthreads * sizeof (pthread_t));
+  assert (args != NULL && threads != NULL);
+  for (i = 0; i < nthreads; i++)
+    {
+      args[i].text = bytes + offset;
+      args[i].board = board;
+      args[i].start = (size_t) i * total / nthreads;
+      args[i].end = ((size_t) i + 1) * total / nthreads;
+      if (i > 0)
+	pthread_create (&threads[i], NULL, parse_worker, &args[i]);
+    }
+  parse_worker (&args[0]);
+  ok = args[0].ok;
+  for (i = 1; i < nthreads; i++)
+    {
+      pthread_join (threads[i], NULL);
+      ok = ok && args[i].ok;
+    }
+
+  free (args);
+  free (threads);
+  munmap ((void*) bytes, st.st_size);
+  if (ok)
+    fseek (input, offset + (long) (2 * total), SEEK_SET);
+  return ok;
+}
+
 static char*
 load_board_values (FILE* input, const int nrows, const int ncols)
 {
+  /* Cell counts are size_t throughout: a 50000x50000 board has 2.5e9
+     cells, which does not fit in an int */
+  const size_t total = (size_t) nrows * ncols;
   char* board = NULL;
   int ngotten = 0;
-  int i = 0;
+  size_t i = 0;
 
   /* Make a new board */
   board = make_board (nrows, ncols);
 
+  if (load_board_values_fast (input, board, total))
+    return board;
+
   /* Fill in the board with values from the input file */
-  for (i = 0; i < nrows * ncols; i++)
+  for (i = 0; i < total; i++)
     {
       ngotten = fscanf (input, "%c\n", &board[i]);
       if (ngotten < 1)
 	{
-	  fprintf (stderr, "*** Ran out of input at item %d ***\n", i);
+	  fprintf (stderr, "*** Ran out of input at item %zu ***\n", i);
 	  fclose (input);
 	  exit (EXIT_FAILURE);
 	}
@@ -72,11 +172,114 @@ load_board_values (FILE* input, const int nrows, const int ncols)
   return board;
 }
 
+/**
+ * Load a run-length-encoded board ("P1R" header, then one "count value"
+ * line per run of equal cells in column-major order) as written by
+ * save_board() with GOL_OUTPUT_FORMAT=rle.
+ */
+static char*
+load_rle_board (FILE* input, int* nrows, int* ncols)
+{
+  char* board = NULL;
+  size_t total = 0;
+  size_t i = 0;
+
+  if (fscanf (input, "P1R\n%d %d\n", nrows, ncols) < 2 ||
+      *nrows < 1 || *ncols < 1)
+    {
+      fprintf (stderr, "*** Failed to read 'P1R' and board dimensions ***\n");
+      fclose (input);
+      exit (EXIT_FAILURE);
+    }
+
+  board = make_board (*nrows, *ncols);
+  total = (size_t) *nrows * *ncols;
+  while (i < total)
+    {
+      long run = 0;
+      int value = 0;
+      if (fscanf (input, "%ld %d\n", &run, &value) < 2 ||
+	  run < 1 || (size_t) run > total - i || (value != 0 && value != 1))
+	{
+	  fprintf (stderr, "*** Bad run-length record at item %zu ***\n", i);
+	  fclose (input);
+	  exit (EXIT_FAILURE);
+	}
+      memset (board + i, value, (size_t) run);
+      i += run;
+    }
+
+  return board;
+}
+
+/**
+ * Load a board in the binary format described in load.h.  The whole file
+ * is mapped read-only, so the cells are expanded straight out of the page
+ * cache with no read() copies and no per-cell parsing.
+ */
+static char*
+load_binary_board (FILE* input, int* nrows, int* ncols)
+{
+  const int fd = fileno (input);
+  struct stat st;
+  const unsigned char* bytes = NULL;
+  char* board = NULL;
+  size_t colbytes = 0;
+  int i, j;
+
+  if (fd < 0 || fstat (fd, &st) != 0)
+    {
+      fprintf (stderr, "*** Failed to stat binary board file ***\n");
+      fclose (input);
+      exit (EXIT_FAILURE);
+    }
+  bytes = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (bytes == MAP_FAILED)
+    {
+      fprintf (stderr, "*** Failed to mmap binary board file ***\n");
+      fclose (input);
+      exit (EXIT_FAILURE);
+    }
+
+  memcpy (nrows, bytes + GOL_BINARY_MAGIC_LEN, sizeof (int));
+  memcpy (ncols, bytes + GOL_BINARY_MAGIC_LEN + sizeof (int), sizeof (int));
+  colbytes = ((size_t) *nrows + 7) / 8;
+  if (*nrows < 1 || *ncols < 1 ||
+      (size_t) st.st_size < GOL_BINARY_HEADER_LEN + colbytes * *ncols)
+    {
+      fprintf (stderr, "*** Binary board file is truncated or corrupt ***\n");
+      fclose (input);
+      exit (EXIT_FAILURE);
+    }
+
+  board = make_board (*nrows, *ncols);
+  for (j = 0; j < *ncols; j++)
+    {
+      const unsigned char* src = bytes + GOL_BINARY_HEADER_LEN + j * colbytes;
+      char* dst = board + (size_t) j * *nrows;
+      for (i = 0; i < *nrows; i++)
+	dst[i] = (src[i >> 3] >> (i & 7)) & 1;
+    }
+
+  munmap ((void*) bytes, st.st_size);
+  return board;
+}
+
 char*
 load_board (FILE* input, int* nrows, int* ncols)
 {
+  char magic[GOL_BINARY_MAGIC_LEN];
+
+  /* Sniff the magic bytes to pick the format; text boards start with
+     "P1\n" so they can never collide with the binary magic */
+  if (fread (magic, 1, sizeof (magic), input) == sizeof (magic) &&
+      memcmp (magic, GOL_BINARY_MAGIC, sizeof (magic)) == 0)
+    return load_binary_board (input, nrows, ncols);
+
+  rewind (input);
+  if (memcmp (magic, "P1R\n", 4) == 0)
+    return load_rle_board (input, nrows, ncols);
+
   load_dimensions (input, nrows, ncols);
   return load_board_values (input, *nrows, *ncols);
 }
-
-
@@ -3,19 +3,31 @@
 
 #include <stdio.h>
 
+/**
+ * Binary board format: the magic bytes, then nrows and ncols as native
+ * ints, then the cells packed eight per byte (LSB first) in column-major
+ * order with each column padded up to a whole byte.  Roughly 16x smaller
+ * than the one-ASCII-char-plus-newline-per-cell text format, and loaded
+ * with a single mmap instead of a per-cell fscanf.
+ */
+#define GOL_BINARY_MAGIC      "GOLB"
+#define GOL_BINARY_MAGIC_LEN  4
+#define GOL_BINARY_HEADER_LEN (GOL_BINARY_MAGIC_LEN + 2 * sizeof (int))
+
 /**
  * From the file stream "input", load the dimensions of the board
  * (storing them in *nrows and *ncols, respectively) and then return a
  * malloc'd pointer to the board (which is stored as a 1-D
- * column-oriented array).
+ * column-oriented array).  The format (text P1 or binary) is detected
+ * from the magic bytes.
  */
 char *
         load_board(FILE *input, int *nrows, int *ncols);
 
 /**
- * Return a malloc'd pointer to a blank board of dimension nrows by
- * ncols.  The board is initialized to contain nonsense values, which
- * may be useful for debugging.
+ * Return a cache-line-aligned, malloc-compatible pointer to a blank
+ * board of dimension nrows by ncols.  The cells are uninitialized: the
+ * first writer of each page decides its NUMA placement.
  */
 char *
         make_board(const int nrows, const int ncols);
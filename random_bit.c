@@ -82,6 +82,38 @@ random_bit ()
 }
 #endif /* USE_MKL_PRNG */
 
+void
+init_random_bit_stream (uint64_t* state, uint32_t seed, int ith)
+{
+  /*
+   * splitmix64 of the seed and stream index: gives well-separated,
+   * well-mixed starting states even for adjacent seeds and indices.
+   */
+  uint64_t z = (((uint64_t) seed << 32) | (uint64_t) seed)
+    + (uint64_t) ith * UINT64_C (0x9e3779b97f4a7c15);
+  z ^= z >> 30;
+  z *= UINT64_C (0xbf58476d1ce4e5b9);
+  z ^= z >> 27;
+  z *= UINT64_C (0x94d049bb133111eb);
+  z ^= z >> 31;
+  *state = (z != 0) ? z : UINT64_C (0x9e3779b97f4a7c15);
+}
+
+uint64_t
+random_bit_word (uint64_t* state)
+{
+  /*
+   * xorshift64*: a few ops per 64 bits.  As with random_bit(), quality
+   * only needs to be good enough that the boards aren't patterned.
+   */
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * UINT64_C (0x2545f4914f6cdd1d);
+}
+
 
 
 
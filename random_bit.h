@@ -26,5 +26,20 @@ random_bit ();
 uint32_t
 get_random_seed ();
 
+/**
+ * Initialize a private PRNG stream for drawing whole words of random
+ * bits.  Distinct ith values give decorrelated streams even from the
+ * same seed, so each thread can own one; streams with distinct states
+ * are safe to use concurrently.
+ */
+void
+init_random_bit_stream (uint64_t* state, uint32_t seed, int ith);
+
+/**
+ * Return 64 random bits at once from a private stream.
+ */
+uint64_t
+random_bit_word (uint64_t* state);
+
 #endif /* _random_bit_h */
 
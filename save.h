@@ -6,7 +6,9 @@
 /**
  * To the file stream "output", save the dimensions (nrows and ncols,
  * respectively) of the board, and then save the contents of the board
- * (assuming that it's stored in column-major order).
+ * (assuming that it's stored in column-major order).  The format is the
+ * P1 text format unless GOL_OUTPUT_FORMAT selects another ("binary" or
+ * "rle"); load_board() reads all three back.
  */
 void
 save_board (FILE* output, const char board[], const int nrows, const int ncols);
@@ -1,8 +1,71 @@
 #ifndef _util_h
 #define _util_h
 
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
+/** Cache line size assumed by the allocation helpers below. */
+#define CACHE_LINE 64
+
+/**
+ * splitmix64 finalizer: scrambles x so that every input bit affects
+ * every output bit.  Used by the verification hashes; XORing mixed
+ * values together gives an order-independent combine, which is what
+ * lets each thread hash its own slice.
+ */
+static inline uint64_t
+hash_mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/** Round nbytes up to a multiple of the cache line. */
+static inline size_t
+cache_round(size_t nbytes) {
+    return (nbytes + (CACHE_LINE - 1)) & ~((size_t) CACHE_LINE - 1);
+}
+
+/**
+ * Bump allocator over a single 64-byte-aligned block.  Every carve is
+ * padded to a cache-line multiple, so buffers handed to different
+ * threads never share a line and SIMD loads never split one.
+ */
+struct arena_t {
+    char *base;
+    size_t used;
+    size_t cap;
+};
+
+/** Returns 0 on success, like posix_memalign(). */
+static inline int
+arena_init(struct arena_t *arena, size_t cap) {
+    arena->used = 0;
+    arena->cap = cache_round(cap);
+    return posix_memalign((void **) &arena->base, CACHE_LINE, arena->cap);
+}
+
+/** Carve nbytes (rounded up to whole lines); NULL when the arena is full. */
+static inline void *
+arena_alloc(struct arena_t *arena, size_t nbytes) {
+    void *p = arena->base + arena->used;
+    nbytes = cache_round(nbytes);
+    if (arena->used + nbytes > arena->cap)
+        return NULL;
+    arena->used += nbytes;
+    return p;
+}
+
+static inline void
+arena_destroy(struct arena_t *arena) {
+    free(arena->base);
+    arena->base = NULL;
+}
+
 /**
  * C's mod ('%') operator is mathematically correct, but it may return
  * a negative remainder even when both inputs are nonnegative.  This